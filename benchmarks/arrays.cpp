@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+/*! Measure encoding and decoding of a joint trajectory of 1000-element vectors.
+ *
+ * Usage: ``bazel run -c opt //benchmarks:arrays``
+ */
+
+#include <palimpsest/Dictionary.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using palimpsest::Dictionary;
+using palimpsest::mpack::ArrayEncoding;
+using palimpsest::mpack::Writer;
+
+namespace {
+
+/*! Measure the best average time of a function.
+ *
+ * @param[in] function Function to measure.
+ * @return Time per call in nanoseconds.
+ */
+template <typename Function>
+double measure(Function function) {
+  constexpr int kNbCalls = 1000;
+  double best = 1e30;
+  for (int repeat = 0; repeat < 10; ++repeat) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int call = 0; call < kNbCalls; ++call) {
+      function();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    best = (ns < best) ? ns : best;
+  }
+  return best / kNbCalls;
+}
+
+/*! Fill a joint trajectory with position, velocity and torque vectors.
+ *
+ * @param[out] trajectory Dictionary to fill.
+ */
+void fill_trajectory(Dictionary &trajectory) {
+  constexpr int kNbPoints = 1000;
+  trajectory("positions") =
+      Eigen::VectorXd::LinSpaced(kNbPoints, 0.0, 1.0).eval();
+  trajectory("velocities") = Eigen::VectorXd::Constant(kNbPoints, 0.5).eval();
+  trajectory("torques") =
+      Eigen::VectorXd::LinSpaced(kNbPoints, -1.0, 1.0).eval();
+}
+
+}  // namespace
+
+int main() {
+  Dictionary trajectory;
+  fill_trajectory(trajectory);
+  Dictionary target;
+  fill_trajectory(target);
+
+  std::printf("Kernel for arrays of doubles: %s\n",
+              palimpsest::mpack::write_doubles_kernel());
+  for (auto encoding : {ArrayEncoding::kArray, ArrayEncoding::kBinary}) {
+    const char *name = (encoding == ArrayEncoding::kArray) ? "array" : "binary";
+    Writer writer;
+    writer.set_array_encoding(encoding);
+    const size_t size = trajectory.serialize(writer);
+    const double serialize_ns =
+        measure([&]() { trajectory.serialize(writer); });
+    const double update_ns =
+        measure([&]() { target.update(writer.data(), size); });
+    const double stream_ns =
+        measure([&]() { target.stream_update(writer.data(), size); });
+
+    std::printf("%s encoding, %zu bytes: %.0f ns per serialize()\n", name,
+                size, serialize_ns);
+    std::printf("%s encoding, %zu bytes: %.0f ns per update()\n", name, size,
+                update_ns);
+    std::printf("%s encoding, %zu bytes: %.0f ns per stream_update()\n", name,
+                size, stream_ns);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2022 Stéphane Caron
+
+/*! Compare child lookup and traversal in the flat child map against the
+ * node-based map it replaced.
+ *
+ * Usage: ``bazel run -c opt //benchmarks:child_map``
+ */
+
+#include <palimpsest/Dictionary.h>
+#include <palimpsest/internal/FlatMap.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using palimpsest::Dictionary;
+using palimpsest::internal::FlatMap;
+
+namespace {
+
+//! Child stand-in, sized like a dictionary node
+struct Child {
+  explicit Child(double x) : value(x) {}
+  double value;
+  char padding[64];
+};
+
+using NodeMap = std::unordered_map<std::string, std::unique_ptr<Child>>;
+
+template <typename Function>
+double nanoseconds_per_op(Function function, size_t nb_ops) {
+  constexpr int kRepeats = 20;
+  double best = 1e30;
+  for (int repeat = 0; repeat < kRepeats; ++repeat) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    const auto stop = std::chrono::steady_clock::now();
+    const double ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    best = (ns < best) ? ns : best;
+  }
+  return best / static_cast<double>(nb_ops);
+}
+
+void benchmark(size_t nb_keys) {
+  std::vector<std::string> keys;
+  std::vector<Dictionary::Key> hashed_keys;
+  for (size_t i = 0; i < nb_keys; ++i) {
+    keys.push_back("key_" + std::to_string(i * 7919));
+  }
+  for (const auto &key : keys) {
+    hashed_keys.emplace_back(key);
+  }
+
+  NodeMap node_map;
+  FlatMap<Child> flat_map;
+  Dictionary dict;
+  for (size_t i = 0; i < nb_keys; ++i) {
+    node_map.try_emplace(keys[i], std::make_unique<Child>(i));
+    flat_map.try_emplace(keys[i], static_cast<double>(i));
+    dict.insert<double>(keys[i], i);
+  }
+
+  constexpr size_t kLookups = 100000;
+  volatile double sink = 0.0;
+
+  const double node_lookup = nanoseconds_per_op(
+      [&]() {
+        double sum = 0.0;
+        for (size_t i = 0; i < kLookups; ++i) {
+          sum += node_map.find(keys[i % nb_keys])->second->value;
+        }
+        sink = sum;
+      },
+      kLookups);
+  const double flat_lookup = nanoseconds_per_op(
+      [&]() {
+        double sum = 0.0;
+        for (size_t i = 0; i < kLookups; ++i) {
+          sum += flat_map.find(keys[i % nb_keys])->value;
+        }
+        sink = sum;
+      },
+      kLookups);
+  const double dict_lookup = nanoseconds_per_op(
+      [&]() {
+        double sum = 0.0;
+        for (size_t i = 0; i < kLookups; ++i) {
+          sum += dict.get<double>(keys[i % nb_keys]);
+        }
+        sink = sum;
+      },
+      kLookups);
+  const double hashed_lookup = nanoseconds_per_op(
+      [&]() {
+        double sum = 0.0;
+        for (size_t i = 0; i < kLookups; ++i) {
+          sum += dict.get<double>(hashed_keys[i % nb_keys]);
+        }
+        sink = sum;
+      },
+      kLookups);
+
+  const size_t nb_passes = kLookups / nb_keys;
+  const double node_traversal = nanoseconds_per_op(
+      [&]() {
+        double sum = 0.0;
+        for (size_t pass = 0; pass < nb_passes; ++pass) {
+          for (const auto &key_child : node_map) {
+            sum += key_child.second->value;
+          }
+        }
+        sink = sum;
+      },
+      nb_passes * nb_keys);
+  const double flat_traversal = nanoseconds_per_op(
+      [&]() {
+        double sum = 0.0;
+        for (size_t pass = 0; pass < nb_passes; ++pass) {
+          for (const auto &key_child : flat_map) {
+            sum += key_child.second.value;
+          }
+        }
+        sink = sum;
+      },
+      nb_passes * nb_keys);
+  (void)sink;
+
+  std::printf("%zu keys\n", nb_keys);
+  std::printf("  lookup: %6.1f ns (unordered_map) %6.1f ns (flat) %6.1f ns "
+              "(Dictionary::get) %6.1f ns (Dictionary::get with Key)\n",
+              node_lookup, flat_lookup, dict_lookup, hashed_lookup);
+  std::printf("  traversal: %6.2f ns (unordered_map) %6.2f ns (flat)\n",
+              node_traversal, flat_traversal);
+}
+
+}  // namespace
+
+int main() {
+  for (size_t nb_keys : {10, 100, 1000}) {
+    benchmark(nb_keys);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+/*! Measure the cost of typed value access.
+ *
+ * Usage: ``bazel run -c opt //benchmarks:get``
+ */
+
+#include <palimpsest/Dictionary.h>
+
+#include <Eigen/Core>
+#include <chrono>
+#include <cstdio>
+
+using palimpsest::Dictionary;
+using namespace palimpsest::literals;  // NOLINT(build/namespaces)
+
+namespace {
+
+struct Base {
+  double value = 1.0;
+};
+
+struct Derived : public Base {
+  double other = 2.0;
+};
+
+template <typename Function>
+double nanoseconds_per_op(Function function, size_t nb_ops) {
+  constexpr int kRepeats = 20;
+  double best = 1e30;
+  for (int repeat = 0; repeat < kRepeats; ++repeat) {
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    const auto stop = std::chrono::steady_clock::now();
+    const double ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    best = (ns < best) ? ns : best;
+  }
+  return best / static_cast<double>(nb_ops);
+}
+
+template <typename T>
+double benchmark_as(Dictionary &dict, size_t nb_ops) {
+  volatile double sink = 0.0;
+  return nanoseconds_per_op(
+      [&]() {
+        double sum = 0.0;
+        for (size_t i = 0; i < nb_ops; ++i) {
+          const T &value = dict.as<T>();
+          if constexpr (std::is_same_v<T, double>) {
+            sum += value;
+          } else if constexpr (std::is_base_of_v<Base, T>) {
+            sum += value.value;
+          } else {
+            sum += value(0);
+          }
+        }
+        sink = sum;
+      },
+      nb_ops);
+}
+
+}  // namespace
+
+int main() {
+  constexpr size_t kNbOps = 1000000;
+  constexpr auto kKey = "number"_key;
+
+  Dictionary dict;
+  dict("number") = 42.0;
+  dict("vector") = Eigen::Vector3d{1.0, 2.0, 3.0};
+  dict.insert<Derived, Base>("derived");
+
+  volatile double sink = 0.0;
+  const double get_with_key = nanoseconds_per_op(
+      [&]() {
+        double sum = 0.0;
+        for (size_t i = 0; i < kNbOps; ++i) {
+          sum += dict.get<double>(kKey);
+        }
+        sink = sum;
+      },
+      kNbOps);
+  (void)sink;
+
+  std::printf("get<double> with Key: %6.2f ns\n", get_with_key);
+  std::printf("as<double>: %6.2f ns\n",
+              benchmark_as<double>(dict("number"), kNbOps));
+  std::printf("as<Eigen::Vector3d>: %6.2f ns\n",
+              benchmark_as<Eigen::Vector3d>(dict("vector"), kNbOps));
+  std::printf("as<Derived>: %6.2f ns\n",
+              benchmark_as<Derived>(dict("derived"), kNbOps));
+  std::printf("as<Base> (registered base): %6.2f ns\n",
+              benchmark_as<Base>(dict("derived"), kNbOps));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+/*! Measure the time a control loop spends logging a 300-key observation.
+ *
+ * Compares writing and flushing each frame to a file stream from the loop,
+ * as in the simple logger example before it used the library logger, with
+ * handing frames over to the background thread of a @ref palimpsest::Logger.
+ * Frames are logged at 1 kHz to a temporary file.
+ *
+ * Then compares the sizes of logs of a changing observation with and without
+ * delta encoding, and the time @ref palimpsest::LogReader takes to read a
+ * frame from each of them.
+ *
+ * Usage: ``bazel run -c opt //benchmarks:logger``
+ */
+
+#include <palimpsest/LogReader.h>
+#include <palimpsest/Logger.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "observation.h"
+
+using benchmarks::count_keys;
+using benchmarks::fill_observation;
+using palimpsest::Dictionary;
+using palimpsest::Logger;
+using palimpsest::LogReader;
+
+namespace {
+
+//! Number of logged frames.
+constexpr int kNbFrames = 5000;
+
+//! Period of the control loop.
+constexpr std::chrono::microseconds kPeriod{1000};
+
+//! Maximum number of frames between keyframes of delta-encoded logs.
+constexpr size_t kKeyframeInterval = 100;
+
+/*! Measure the time spent in a logging function at each cycle of a loop.
+ *
+ * @param[in, out] observation Dictionary updated and logged at each cycle.
+ * @param[in] log Function logging the dictionary.
+ * @return Sorted durations of calls in microseconds.
+ */
+template <typename LogFunction>
+std::vector<double> measure(Dictionary &observation, LogFunction log) {
+  std::vector<double> durations;
+  durations.reserve(kNbFrames);
+  auto &position = observation("servo")("joint_0")("position").as<double>();
+  auto next_cycle = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < kNbFrames; ++frame) {
+    position = 0.001 * frame;
+    const auto start = std::chrono::steady_clock::now();
+    log();
+    const auto stop = std::chrono::steady_clock::now();
+    durations.push_back(
+        std::chrono::duration<double, std::micro>(stop - start).count());
+    next_cycle += kPeriod;
+    std::this_thread::sleep_until(next_cycle);
+  }
+  std::sort(durations.begin(), durations.end());
+  return durations;
+}
+
+//! Report the median, 99th percentile and maximum of sorted durations.
+void report(const char *name, const std::vector<double> &durations) {
+  const double median = durations[durations.size() / 2];
+  const double p99 = durations[durations.size() * 99 / 100];
+  std::printf("%-24s %8.1f us median, %8.1f us p99, %8.1f us max\n", name,
+              median, p99, durations.back());
+}
+
+/*! Update the observation like a robot would between two frames.
+ *
+ * @param[in, out] observation Dictionary filled by fill_observation.
+ * @param[in] frame Frame number.
+ *
+ * Joint positions, velocities and torques, the IMU and time change at every
+ * frame, while temperatures, voltages and modes change every second.
+ */
+void step_observation(Dictionary &observation, int frame) {
+  const double time = 0.001 * frame;
+  auto &servo = observation("servo");
+  for (int i = 0; i < 40; ++i) {
+    auto &joint = servo("joint_" + std::to_string(i));
+    joint("position") = 0.1 * i + std::sin(time + i);
+    joint("velocity") = std::cos(time + i);
+    joint("torque") = 0.5 * std::sin(2.0 * time + i);
+    if (frame % 1000 == 0) {
+      joint("temperature") = 42.0 + 0.001 * frame;
+      joint("voltage") = 18.0 - 0.0001 * frame;
+    }
+  }
+  auto &imu = observation("imu");
+  imu("angular_velocity") = Eigen::Vector3d{std::sin(time), 0.0, 0.1};
+  imu("linear_acceleration") = Eigen::Vector3d{0.1, std::cos(time), 9.81};
+  observation("time") = time;
+}
+
+/*! Log a changing observation without pacing, and measure the log.
+ *
+ * @param[in] path Path to the log file.
+ * @param[in] keyframe_interval Maximum number of frames between keyframes,
+ *     zero to write only keyframes.
+ * @param[out] read_time Average time to read a frame, in microseconds.
+ * @return Size of the log file in bytes.
+ */
+off_t measure_log(const std::string &path, size_t keyframe_interval,
+                  double &read_time) {
+  Dictionary observation;
+  fill_observation(observation);
+  {
+    Logger logger(path, 64 * 1024, 64, Logger::SyncPolicy::kNone,
+                  std::chrono::seconds(1), /* index_interval = */ 256);
+    logger.set_delta_encoding(keyframe_interval, std::chrono::hours(1));
+    for (int frame = 0; frame < kNbFrames; ++frame) {
+      step_observation(observation, frame);
+      while (!logger.write(observation)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  }
+  struct stat log_stat;
+  ::stat(path.c_str(), &log_stat);
+
+  LogReader log(path);
+  Dictionary replayed;
+  constexpr int kNbReads = 1000;
+  const auto start = std::chrono::steady_clock::now();
+  for (int read = 0; read < kNbReads; ++read) {
+    log.replay(static_cast<size_t>(read * 7919) % log.nb_frames(), replayed);
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  read_time =
+      std::chrono::duration<double, std::micro>(stop - start).count() /
+      kNbReads;
+  ::unlink(path.c_str());
+  return log_stat.st_size;
+}
+
+}  // namespace
+
+int main() {
+  Dictionary observation;
+  fill_observation(observation);
+  const std::string path =
+      "/tmp/palimpsest_benchmark_" + std::to_string(::getpid()) + ".mpack";
+
+  palimpsest::mpack::Writer writer;
+  std::ofstream file(path, std::ofstream::binary);
+  const auto flushed = measure(observation, [&]() {
+    const size_t size = observation.serialize(writer);
+    file.write(writer.data(), static_cast<std::streamsize>(size));
+    file.flush();
+  });
+  file.close();
+
+  std::uint64_t dropped_frames = 0;
+  size_t max_queue_depth = 0;
+  std::vector<double> logged;
+  {
+    Logger logger(path);
+    logged = measure(observation, [&]() { logger.write(observation); });
+    dropped_frames = logger.dropped_frames();
+    max_queue_depth = logger.max_queue_depth();
+  }
+  ::unlink(path.c_str());
+
+  std::printf("%zu keys, %zu bytes, %d frames at %.0f Hz\n",
+              count_keys(observation), observation.serialized_size(),
+              kNbFrames, 1e6 / kPeriod.count());
+  report("write and flush", flushed);
+  report("Logger::write", logged);
+  std::printf("Logger: %" PRIu64 " dropped frames, max queue depth %zu\n",
+              dropped_frames, max_queue_depth);
+
+  double keyframe_read_time = 0.0;
+  double delta_read_time = 0.0;
+  const off_t keyframe_size = measure_log(path, 0, keyframe_read_time);
+  const off_t delta_size =
+      measure_log(path, kKeyframeInterval, delta_read_time);
+  std::printf("keyframes only           %8.1f kB, %8.1f us per read\n",
+              keyframe_size / 1e3, keyframe_read_time);
+  std::printf("keyframe every %-3zu       %8.1f kB, %8.1f us per read\n",
+              kKeyframeInterval, delta_size / 1e3, delta_read_time);
+  std::printf("delta encoding: %.1fx smaller\n",
+              static_cast<double>(keyframe_size) / delta_size);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <palimpsest/Dictionary.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <string>
+
+namespace benchmarks {
+
+using palimpsest::Dictionary;
+
+//! Count keys in a dictionary, including those of sub-dictionaries.
+inline size_t count_keys(const Dictionary &dict) {
+  size_t nb_keys = 0;
+  for (const auto &key : dict.keys()) {
+    nb_keys += 1 + count_keys(dict(key));
+  }
+  return nb_keys;
+}
+
+/*! Fill an observation dictionary with 300 keys.
+ *
+ * @param[out] observation Dictionary to fill.
+ */
+inline void fill_observation(Dictionary &observation) {
+  auto &servo = observation("servo");
+  for (int i = 0; i < 40; ++i) {
+    auto &joint = servo("joint_" + std::to_string(i));
+    joint("position") = 0.1 * i;
+    joint("velocity") = 0.0;
+    joint("torque") = 0.0;
+    joint("temperature") = 42.0;
+    joint("voltage") = 18.0;
+    joint("mode") = std::string("position");
+  }
+  auto &imu = observation("imu");
+  imu("orientation") = Eigen::Quaterniond::Identity();
+  imu("angular_velocity") = Eigen::Vector3d{0.0, 0.0, 0.0};
+  imu("linear_acceleration") = Eigen::Vector3d{0.0, 0.0, 9.81};
+  auto &base = observation("base_orientation");
+  base("pitch") = 0.0;
+  base("angular_velocity") = Eigen::Vector3d{0.0, 0.0, 0.0};
+  auto &cpu = observation("cpu");
+  cpu("temperature") = 51.0;
+  cpu("frequency") = 1.5e9;
+  cpu("load") = 0.5;
+  auto &odometry = observation("wheel_odometry");
+  odometry("position") = 0.0;
+  odometry("velocity") = 0.0;
+  observation("floor_contact")("contact") = true;
+  observation("status") = std::string("ok");
+  observation("time") = 0.0;
+  observation("number") = 1000u;
+}
+
+}  // namespace benchmarks
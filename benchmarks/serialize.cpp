@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+/*! Measure serialization of a robot observation dictionary with 300 keys.
+ *
+ * Usage: ``bazel run -c opt //benchmarks:serialize``
+ */
+
+#include <palimpsest/Dictionary.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "observation.h"
+
+using benchmarks::count_keys;
+using benchmarks::fill_observation;
+using palimpsest::Dictionary;
+
+namespace {
+
+/*! Measure the best average time of a serialization function.
+ *
+ * @param[in] serialize Function serializing the dictionary.
+ * @return Time per call in nanoseconds.
+ */
+template <typename SerializeFunction>
+double measure(SerializeFunction serialize) {
+  constexpr int kNbCalls = 10000;
+  double best = 1e30;
+  for (int repeat = 0; repeat < 10; ++repeat) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int call = 0; call < kNbCalls; ++call) {
+      serialize();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    best = (ns < best) ? ns : best;
+  }
+  return best / kNbCalls;
+}
+
+}  // namespace
+
+int main() {
+  Dictionary observation;
+  fill_observation(observation);
+
+  std::vector<char> buffer;
+  const size_t size = observation.serialize(buffer);
+  const double vector_ns = measure([&]() { observation.serialize(buffer); });
+
+  palimpsest::mpack::Writer writer;
+  const double writer_ns = measure([&]() { observation.serialize(writer); });
+
+  std::vector<char> memory(size);
+  const double fixed_ns = measure(
+      [&]() { observation.serialize(memory.data(), memory.size()); });
+
+  size_t total = 0;
+  const double size_ns =
+      measure([&]() { total += observation.serialized_size(); });
+
+  std::printf("%zu keys, %zu bytes: %.0f ns per serialize()\n",
+              count_keys(observation), size, vector_ns);
+  std::printf("%zu keys, %zu bytes: %.0f ns per serialize() with one writer\n",
+              count_keys(observation), size, writer_ns);
+  std::printf("%zu keys, %zu bytes: %.0f ns per serialize() to fixed memory\n",
+              count_keys(observation), size, fixed_ns);
+  std::printf("%zu keys, %zu bytes: %.0f ns per serialized_size()\n",
+              count_keys(observation), total / 100000, size_ns);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+/*! Measure round trips of a 300-key observation between two processes.
+ *
+ * The parent process publishes the observation on a ping channel, and the
+ * child process publishes it back on a pong channel as soon as it reads it.
+ * Both processes poll their channel, yielding the CPU between polls so that
+ * the benchmark also runs on a single core. Round trips thus measure the
+ * latency of serializing, copying and updating through shared memory, plus
+ * that of the scheduler when both processes share a core.
+ *
+ * Usage: ``bazel run -c opt //benchmarks:shm_channel``
+ */
+
+#include <palimpsest/ShmChannel.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "observation.h"
+
+using benchmarks::count_keys;
+using benchmarks::fill_observation;
+using palimpsest::Dictionary;
+using palimpsest::ShmChannel;
+using palimpsest::exceptions::SystemError;
+
+namespace {
+
+//! Number of round trips before measurements start.
+constexpr int kNbWarmups = 1000;
+
+//! Number of measured round trips.
+constexpr int kNbRoundTrips = 20000;
+
+//! Capacity of both channels in bytes.
+constexpr size_t kCapacity = 64 * 1024;
+
+/*! Open a channel, waiting for the other process to create it.
+ *
+ * @param[in] name Name of the channel.
+ * @return Channel opened as a reader.
+ */
+std::unique_ptr<ShmChannel> open_channel(const std::string &name) {
+  for (;;) {
+    try {
+      return std::make_unique<ShmChannel>(name);
+    } catch (const SystemError &) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+/*! Publish back every frame read from the ping channel.
+ *
+ * The parent process opens the pong channel before its first ping, so that
+ * it keeps reading it after this function returns and unlinks it.
+ *
+ * @param[in] ping_name Name of the ping channel.
+ * @param[in] pong_name Name of the pong channel.
+ */
+void echo(const std::string &ping_name, const std::string &pong_name) {
+  ShmChannel pong(pong_name, kCapacity);
+  ShmChannel ping(ping_name);
+  Dictionary observation;
+  for (int i = 0; i < kNbWarmups + kNbRoundTrips; ++i) {
+    while (!ping.update(observation)) {
+      std::this_thread::yield();
+    }
+    pong.write(observation);
+  }
+}
+
+}  // namespace
+
+int main() {
+  const std::string suffix = std::to_string(::getpid());
+  const std::string ping_name = "/palimpsest_benchmark_ping_" + suffix;
+  const std::string pong_name = "/palimpsest_benchmark_pong_" + suffix;
+  ShmChannel ping(ping_name, kCapacity);
+
+  const pid_t child = ::fork();
+  if (child == 0) {
+    echo(ping_name, pong_name);
+    ::_exit(EXIT_SUCCESS);
+  }
+
+  Dictionary observation;
+  fill_observation(observation);
+  Dictionary echoed;
+  std::unique_ptr<ShmChannel> pong = open_channel(pong_name);
+  std::vector<double> round_trips;
+  round_trips.reserve(kNbRoundTrips);
+  size_t size = 0;
+  for (int i = 0; i < kNbWarmups + kNbRoundTrips; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    size = ping.write(observation).size;
+    while (!pong->update(echoed)) {
+      std::this_thread::yield();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    if (i >= kNbWarmups) {
+      round_trips.push_back(
+          std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+  }
+  ::waitpid(child, nullptr, 0);
+
+  std::sort(round_trips.begin(), round_trips.end());
+  auto percentile = [&](double p) {
+    return round_trips[static_cast<size_t>(p * (round_trips.size() - 1))];
+  };
+  std::printf("%zu keys, %zu bytes, %d round trips between processes\n",
+              count_keys(observation), size, kNbRoundTrips);
+  std::printf("Round trip: %.1f us median, %.1f us p99, %.1f us max\n",
+              percentile(0.5), percentile(0.99), round_trips.back());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+/*! Measure updates of a robot observation dictionary with 300 keys.
+ *
+ * Usage: ``bazel run -c opt //benchmarks:update``
+ */
+
+#include <palimpsest/Dictionary.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "observation.h"
+
+using benchmarks::count_keys;
+using benchmarks::fill_observation;
+using palimpsest::Dictionary;
+
+namespace {
+
+/*! Measure the best average time of an update function.
+ *
+ * @param[in] update Function updating the dictionary from the message.
+ * @return Time per call in nanoseconds.
+ */
+template <typename UpdateFunction>
+double measure(UpdateFunction update) {
+  constexpr int kNbCalls = 10000;
+  double best = 1e30;
+  for (int repeat = 0; repeat < 10; ++repeat) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int call = 0; call < kNbCalls; ++call) {
+      update();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    best = (ns < best) ? ns : best;
+  }
+  return best / kNbCalls;
+}
+
+}  // namespace
+
+int main() {
+  Dictionary observation;
+  fill_observation(observation);
+  std::vector<char> buffer;
+  const size_t size = observation.serialize(buffer);
+
+  Dictionary target;
+  fill_observation(target);
+  const double tree_ns = measure([&]() { target.update(buffer.data(), size); });
+  palimpsest::mpack::Parser parser;
+  const double parser_ns =
+      measure([&]() { target.update(buffer.data(), size, parser); });
+  const double stream_ns =
+      measure([&]() { target.stream_update(buffer.data(), size); });
+
+  std::printf("%zu keys, %zu bytes: %.0f ns per update()\n",
+              count_keys(observation), size, tree_ns);
+  std::printf("%zu keys, %zu bytes: %.0f ns per update() with a parser\n",
+              count_keys(observation), size, parser_ns);
+  std::printf("%zu keys, %zu bytes: %.0f ns per stream_update()\n",
+              count_keys(observation), size, stream_ns);
+  std::printf("Key-order cache hit rate: %.1f%%\n",
+              100.0 * target.key_order_stats().hit_rate());
+  return EXIT_SUCCESS;
+}
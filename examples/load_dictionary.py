@@ -20,6 +20,25 @@ import argparse
 
 import msgpack
 
+# Binary object written before each delta frame of a log, see LogIndex
+DELTA_MARKER = b"plmpdelt"
+
+
+def update(dictionary: dict, new_dict: dict) -> None:
+    """Update a dictionary recursively, like ``Dictionary::update`` does.
+
+    Args:
+        dictionary: Dictionary to update.
+        new_dict: Full or partial dictionary, for instance a delta from
+            ``Dictionary::serialize_delta``, to update it with.
+    """
+    for key, value in new_dict.items():
+        if isinstance(value, dict) and isinstance(dictionary.get(key), dict):
+            update(dictionary[key], value)
+        else:
+            dictionary[key] = value
+
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument("file", help="MessagePack file to load")
@@ -30,7 +49,17 @@ if __name__ == "__main__":
     with open(args.file, "rb") as buffer:
         data = buffer.read()
         unpacker.feed(data)
+    is_delta = False
     for new_dict in unpacker:
-        dictionary.update(new_dict)
+        if not isinstance(new_dict, dict):
+            # Delta marker before the next frame, or index block of an
+            # indexed log
+            is_delta = is_delta or new_dict == DELTA_MARKER
+            continue
+        if is_delta:  # only values that changed since the previous frame
+            update(dictionary, new_dict)
+        else:  # keyframe holding every value
+            dictionary = new_dict
+        is_delta = False
         print(dictionary)
         unpacked += 1
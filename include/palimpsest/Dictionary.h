@@ -15,21 +15,34 @@
 #include <spdlog/spdlog.h>
 
 #include <Eigen/Core>
+#include <cstring>
 #include <functional>
 #include <memory>
+#include <memory_resource>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "palimpsest/exceptions/FrozenError.h"
+#include "palimpsest/exceptions/KeyError.h"
 #include "palimpsest/exceptions/TypeError.h"
 #include "palimpsest/internal/Allocator.h"
-#include "palimpsest/internal/is_valid_hash.h"
+#include "palimpsest/internal/FlatMap.h"
+#include "palimpsest/internal/hash.h"
+#include "palimpsest/internal/is_trivially_relocatable.h"
 #include "palimpsest/internal/type_name.h"
+#include "palimpsest/internal/type_tag.h"
 #include "palimpsest/json/write.h"
+#include "palimpsest/mpack/Parser.h"
 #include "palimpsest/mpack/Writer.h"
+#include "palimpsest/mpack/binary.h"
+#include "palimpsest/mpack/expect.h"
 #include "palimpsest/mpack/read.h"
+#include "palimpsest/mpack/resize.h"
+#include "palimpsest/mpack/size.h"
 #include "palimpsest/mpack/write.h"
 
 namespace palimpsest {
@@ -96,11 +109,26 @@ using exceptions::TypeError;
  */
 class Dictionary {
   /*! Internal wrapper around an object and its type information.
+   *
+   * Small trivially relocatable objects, such as numbers or fixed-size Eigen
+   * types, are stored inline. Other objects are allocated separately.
    *
    * @note Dictionary values are move-only.
    */
   class Value {
    public:
+    //! Maximum size in bytes of objects stored inline.
+    static constexpr std::size_t kInlineSize = 32;
+
+    //! Alignment in bytes of the inline storage.
+    static constexpr std::size_t kInlineAlignment = 16;
+
+    //! Check whether objects of type T are stored inline.
+    template <typename T>
+    static constexpr bool is_inline =
+        sizeof(T) <= kInlineSize && alignof(T) <= kInlineAlignment &&
+        internal::is_trivially_relocatable<T>::value;
+
     //! Default constructor.
     Value() = default;
 
@@ -110,24 +138,51 @@ class Dictionary {
     //! No copy assignment operator.
     Value &operator=(const Value &) = delete;
 
-    //! Default move constructor.
-    Value(Value &&) = default;
+    /*! Move constructor.
+     *
+     * @param[in] other Value to take ownership of the internal buffer from.
+     */
+    Value(Value &&other) noexcept { steal_(other); }
 
-    //! Default move assignment operator.
-    Value &operator=(Value &&) = default;
+    /*! Move assignment operator.
+     *
+     * @param[in] other Value to take ownership of the internal buffer from.
+     */
+    Value &operator=(Value &&other) noexcept {
+      if (this != &other) {
+        if (this->buffer) {
+          destroy_();
+        }
+        steal_(other);
+      }
+      return *this;
+    }
 
     //! Destruct the object and free the internal buffer.
     ~Value() {
       if (this->buffer) {
-        destroy_(*this);
+        destroy_();
       }
     }
 
-    //! Allocate the internal buffer.
+    /*! Allocate the internal buffer.
+     *
+     * @param[in] resource Memory resource to allocate the buffer from, or
+     *     nullptr to use the default allocator. Unused if the object is
+     *     stored inline.
+     */
     template <typename T>
-    void allocate() {
-      this->buffer.reset(
-          reinterpret_cast<uint8_t *>(internal::Allocator<T>().allocate(1)));
+    void allocate(std::pmr::memory_resource *resource) {
+      this->resource = resource;
+      if constexpr (is_inline<T>) {
+        this->buffer = storage_;
+      } else if (resource != nullptr) {
+        this->buffer = static_cast<uint8_t *>(
+            resource->allocate(sizeof(T), internal::alignment<T>::value));
+      } else {
+        this->buffer =
+            reinterpret_cast<uint8_t *>(internal::Allocator<T>().allocate(1));
+      }
     }
 
     /*! Update value from an MPack node.
@@ -135,48 +190,80 @@ class Dictionary {
      * @param[in] node MPack tree node.
      * @throw TypeError if the deserialized type does not match.
      */
-    void deserialize(mpack_node_t node) { deserialize_(*this, node); }
+    void deserialize(mpack_node_t node) { ops_->deserialize(*this, node); }
+
+    /*! Update value from a MessagePack stream.
+     *
+     * @param[in, out] reader MPack reader positioned at the value.
+     *
+     * @note A type mismatch is reported by flagging the reader with
+     *     mpack_error_type.
+     */
+    void expect(mpack_reader_t *reader) { ops_->expect(*this, reader); }
 
     /*! Print value to an output stream;
      *
      * @param[out] stream Output stream to print to.
      */
-    void print(std::ostream &stream) const { print_(*this, stream); }
+    void print(std::ostream &stream) const { ops_->print(*this, stream); }
 
     /*! Serialize value to a MessagePack writer.
      *
      * @param[out] writer Writer to serialize to.
      */
     void serialize(mpack::Writer &writer) const {
-      serialize_(*this, writer.mpack_writer());
+      ops_->serialize(*this, writer);
+    }
+
+    //! Number of bytes @ref serialize writes.
+    size_t serialized_size() const {
+      return ops_->fixed_serialized_size > 0 ? ops_->fixed_serialized_size
+                                             : ops_->serialized_size(*this);
+    }
+
+    //! Whether the serialized size of the value depends on its contents.
+    bool has_variable_serialized_size() const noexcept {
+      return ops_->fixed_serialized_size == 0;
     }
 
-    /*! Allocate object and register internal functions.
+    /*! Move the object to another value, allocating it from a given resource.
+     *
+     * @param[out] target Empty value to move the object to.
+     * @param[in] resource Memory resource to allocate the new buffer from, or
+     *     nullptr to use the default allocator.
+     *
+     * After relocation, this value is empty.
+     */
+    void relocate(Value &target, std::pmr::memory_resource *resource) {
+      ops_->relocate(*this, target, resource);
+    }
+
+    //! Upper bound on the bytes allocated for the object, zero if inline.
+    std::size_t allocated_bytes() const { return ops_->allocated_bytes; }
+
+    //! Name of the object's type.
+    const char *type_name() const { return ops_->type_name(); }
+
+    //! Whether updates of the object follow @ref resize_policy.
+    bool has_resize_policy() const noexcept { return ops_->has_resize_policy; }
+
+    /*! Reserve capacity for updates of the object.
+     *
+     * @param[in] capacity Number of elements to reserve.
+     *
+     * @throw TypeError if the object has no capacity.
+     */
+    void reserve(std::size_t capacity) { ops_->reserve(*this, capacity); }
+
+    /*! Register the operations table of the allocated object.
      *
      * @return Reference to allocated object.
      */
     template <typename T, typename... ArgsT>
     T &setup() {
-      this->type_name = &internal::type_name<T>;
-      this->same = &internal::is_valid_hash<T, ArgsT...>;
-      deserialize_ = [](Value &self, mpack_node_t node) {
-        T *cast_buffer = reinterpret_cast<T *>(self.buffer.get());
-        mpack::read<T>(node, *cast_buffer);
-      };
-      destroy_ = [](Value &self) {
-        T *p = reinterpret_cast<T *>(self.buffer.release());
-        p->~T();
-        internal::Allocator<T>().deallocate(p, 1);
-      };
-      print_ = [](const Value &self, std::ostream &stream) {
-        const T *cast_buffer = reinterpret_cast<const T *>(self.buffer.get());
-        json::write<T>(stream, *cast_buffer);
-      };
-      serialize_ = [](const Value &self, mpack_writer_t *writer) {
-        const T *cast_buffer = reinterpret_cast<const T *>(self.buffer.get());
-        mpack::write<T>(writer, *cast_buffer);
-      };
-      return *(reinterpret_cast<T *>(this->buffer.get()));
+      ops_ = &TypedOps<T, ArgsT...>::table;
+      resize_policy = mpack::default_resize_policy<T>;
+      return *(reinterpret_cast<T *>(this->buffer));
     }
 
     /*! Cast value to its object's type after checking that it matches T.
@@ -187,60 +274,508 @@ class Dictionary {
      */
     template <typename T>
     T &get_reference() const {
-      if (!this->same(typeid(T).hash_code())) {
+      constexpr std::uint64_t tag = internal::type_tag_v<T>;
+      if (ops_->tag != tag && !is_base_(tag)) {
         std::string cast_type = this->type_name();
         throw TypeError(__FILE__, __LINE__,
                         "Object has type \"" + cast_type +
                             "\" but is being cast to type \"" +
                             typeid(T).name() + "\".");
       }
-      return *(reinterpret_cast<T *>(this->buffer.get()));
+      return *(reinterpret_cast<T *>(this->buffer));
+    }
+
+   private:
+    //! Type-specific operations on values, shared by all values of a type.
+    struct Ops {
+      //! Function returning the name of the object's type.
+      const char *(*type_name)();
+
+      //! Tag of the object's type.
+      std::uint64_t tag;
+
+      //! Tags of the base classes the object can also be cast to.
+      const std::uint64_t *base_tags;
+
+      //! Number of base classes.
+      std::size_t nb_base_tags;
+
+      //! Upper bound on the bytes allocated for the object, zero if inline.
+      std::size_t allocated_bytes;
+
+      //! Whether updates of the object follow a resize policy.
+      bool has_resize_policy;
+
+      //! Function that reserves capacity for updates of the object.
+      void (*reserve)(Value &, std::size_t);
+
+      //! Function that updates the value from a MessagePack node.
+      void (*deserialize)(Value &, mpack_node_t);
+
+      //! Function that updates the value from a MessagePack stream.
+      void (*expect)(Value &, mpack_reader_t *);
+
+      //! Function that destructs the object and frees the internal buffer.
+      void (*destroy)(Value &);
+
+      //! Function that prints the value to an output stream.
+      void (*print)(const Value &, std::ostream &);
+
+      //! Function that serializes the value to a MessagePack writer.
+      void (*serialize)(const Value &, mpack::Writer &);
+
+      //! Serialized size of every object of this type, zero if it varies.
+      std::size_t fixed_serialized_size;
+
+      //! Function that computes the serialized size of the value.
+      std::size_t (*serialized_size)(const Value &);
+
+      //! Function that moves the object to another value.
+      void (*relocate)(Value &, Value &, std::pmr::memory_resource *);
+    };
+
+    /*! Operations table for objects of type T.
+     *
+     * @tparam T Type of the object.
+     * @tparam ArgsT Base classes of T that the object can also be cast to.
+     */
+    template <typename T, typename... ArgsT>
+    struct TypedOps {
+      //! Reserve capacity for updates of the object.
+      static void reserve(Value &self, std::size_t capacity) {
+        T *cast_buffer = reinterpret_cast<T *>(self.buffer);
+        if constexpr (mpack::has_capacity<T>) {
+          cast_buffer->reserve(capacity);
+        } else {
+          throw TypeError(__FILE__, __LINE__,
+                          std::string("Object of type \"") +
+                              internal::type_name<T>() +
+                              "\" has no capacity to reserve.");
+        }
+      }
+
+      //! Update the object from a MessagePack node.
+      static void deserialize(Value &self, mpack_node_t node) {
+        T *cast_buffer = reinterpret_cast<T *>(self.buffer);
+        if constexpr (mpack::has_resize_policy<T>) {
+          mpack::read(node, *cast_buffer, self.resize_policy);
+        } else {
+          mpack::read<T>(node, *cast_buffer);
+        }
+      }
+
+      //! Update the object from a MessagePack stream.
+      static void expect(Value &self, mpack_reader_t *reader) {
+        T *cast_buffer = reinterpret_cast<T *>(self.buffer);
+        if constexpr (mpack::has_resize_policy<T>) {
+          mpack::expect(reader, *cast_buffer, self.resize_policy);
+        } else {
+          mpack::expect<T>(reader, *cast_buffer);
+        }
+      }
+
+      //! Destruct the object and free its buffer.
+      static void destroy(Value &self) {
+        T *p = reinterpret_cast<T *>(self.buffer);
+        self.buffer = nullptr;
+        p->~T();
+        if constexpr (is_inline<T>) {
+          return;
+        } else if (self.resource != nullptr) {
+          self.resource->deallocate(p, sizeof(T),
+                                    internal::alignment<T>::value);
+        } else {
+          internal::Allocator<T>().deallocate(p, 1);
+        }
+      }
+
+      //! Print the object to an output stream.
+      static void print(const Value &self, std::ostream &stream) {
+        const T *cast_buffer = reinterpret_cast<const T *>(self.buffer);
+        json::write<T>(stream, *cast_buffer);
+      }
+
+      //! Serialize the object to a MessagePack writer.
+      static void serialize(const Value &self, mpack::Writer &writer) {
+        const T *cast_buffer = reinterpret_cast<const T *>(self.buffer);
+        if constexpr (mpack::has_binary_encoding<T>) {
+          if (writer.array_encoding() == mpack::ArrayEncoding::kBinary) {
+            mpack::write_binary<T>(writer.mpack_writer(), *cast_buffer);
+            return;
+          }
+        }
+        mpack::write<T>(writer.mpack_writer(), *cast_buffer);
+      }
+
+      //! Size of the serialization of the object.
+      static std::size_t serialized_size(const Value &self) {
+        const T *cast_buffer = reinterpret_cast<const T *>(self.buffer);
+        return mpack::serialized_size<T>(*cast_buffer);
+      }
+
+      //! Move the object to another value.
+      static void relocate(Value &self, Value &target,
+                           std::pmr::memory_resource *resource) {
+        T *p = reinterpret_cast<T *>(self.buffer);
+        target.allocate<T>(resource);
+        new (target.buffer) T(std::move(*p));
+        target.ops_ = self.ops_;
+        target.resize_policy = self.resize_policy;
+        destroy(self);
+      }
+
+      //! Tags of the base classes, with a sentinel to avoid empty arrays.
+      static constexpr std::uint64_t base_tags[] = {
+          internal::type_tag_v<ArgsT>..., 0};
+
+      //! Operations table, unique to each (T, ArgsT...) combination.
+      static constexpr Ops table = {&internal::type_name<T>,
+                                    internal::type_tag_v<T>,
+                                    base_tags,
+                                    sizeof...(ArgsT),
+                                    is_inline<T>
+                                        ? 0
+                                        : sizeof(T) +
+                                              internal::alignment<T>::value,
+                                    mpack::has_resize_policy<T>,
+                                    &reserve,
+                                    &deserialize,
+                                    &expect,
+                                    &destroy,
+                                    &print,
+                                    &serialize,
+                                    mpack::fixed_serialized_size<T>,
+                                    &serialized_size,
+                                    &relocate};
+    };
+
+    /*! Take ownership of the internal buffer of another value.
+     *
+     * @param[in] other Value to steal from. Its buffer is reset to nullptr.
+     */
+    void steal_(Value &other) noexcept {
+      if (other.buffer == other.storage_) {
+        std::memcpy(storage_, other.storage_, kInlineSize);
+        buffer = storage_;
+      } else {
+        buffer = other.buffer;
+      }
+      resource = other.resource;
+      resize_policy = other.resize_policy;
+      ops_ = other.ops_;
+      other.buffer = nullptr;
+    }
+
+    //! Destruct the object and free the internal buffer.
+    void destroy_() { ops_->destroy(*this); }
+
+    /*! Check whether a type is a registered base class of the object.
+     *
+     * @param[in] tag Tag of the type to check.
+     */
+    bool is_base_(std::uint64_t tag) const noexcept {
+      for (std::size_t i = 0; i < ops_->nb_base_tags; ++i) {
+        if (ops_->base_tags[i] == tag) {
+          return true;
+        }
+      }
+      return false;
     }
 
    public:
     //! Internal buffer that holds the actual object.
-    std::unique_ptr<uint8_t[]> buffer = nullptr;
+    uint8_t *buffer = nullptr;
 
-    //! Function returning the name of the object's type.
-    const char *(*type_name)();
+    //! Memory resource the buffer was allocated from, nullptr for default.
+    std::pmr::memory_resource *resource = nullptr;
 
-    //! Function that checks if a given type matches the object's type.
-    bool (*same)(std::size_t);
+    //! What updates do with incoming lengths that do not fit the object.
+    mpack::ResizePolicy resize_policy = mpack::ResizePolicy::kGrow;
 
    private:
-    //! Function that updates the value from a MessagePack node.
-    void (*deserialize_)(Value &, mpack_node_t);
+    //! Operations on the object, set by @ref setup.
+    const Ops *ops_ = nullptr;
 
-    //! Function that destructs the object and frees the internal buffer.
-    void (*destroy_)(Value &);
+    //! Inline storage for small objects.
+    alignas(kInlineAlignment) uint8_t storage_[kInlineSize];
+  };
 
-    //! Function that prints the value to an output stream.
-    void (*print_)(const Value &, std::ostream &);
+ public:
+  /*! Key with a precomputed hash.
+   *
+   * Looking up a string key hashes it every time. In loops that access the
+   * same keys over and over, keys can instead be hashed once, or even at
+   * compile time using the ``_key`` literal:
+   *
+   * @code{cpp}
+   * using namespace palimpsest::literals;
+   *
+   * constexpr auto kImu = "imu"_key;
+   * constexpr auto kOrientation = "orientation"_key;
+   *
+   * auto &orientation =
+   *     dict("observation")(kImu).get<Eigen::Quaterniond>(kOrientation);
+   * @endcode
+   *
+   * @note A key only views its name, which must outlive it. This is always
+   * the case for keys built from string literals.
+   */
+  class Key {
+   public:
+    /*! Hash a key name.
+     *
+     * @param[in] name Name of the key.
+     */
+    constexpr explicit Key(std::string_view name) noexcept
+        : name_(name), hash_(internal::fnv1a(name)) {}
+
+    //! Name of the key.
+    constexpr std::string_view name() const noexcept { return name_; }
+
+    //! Hash of the key name.
+    constexpr std::uint64_t hash() const noexcept { return hash_; }
 
-    //! Function that serializes the value to a MessagePack writer.
-    void (*serialize_)(const Value &, mpack_writer_t *);
+   private:
+    //! Name of the key.
+    std::string_view name_;
+
+    //! Hash of the key name.
+    std::uint64_t hash_;
+  };
+
+  /*! Typed handle to a value resolved from a path.
+   *
+   * A handle caches a pointer to its value, so that accessing it does not
+   * look up keys nor check types again. It also records the structural
+   * generation of every dictionary along its path: when one of them has been
+   * modified since, for instance because a key was removed or the value was
+   * replaced, the handle is stale and resolves its path again on the next
+   * access.
+   *
+   * @code{cpp}
+   * auto position = dict.resolve<Eigen::Vector3d>("bodies/plane/position");
+   * position->z() += 1.0;
+   * @endcode
+   *
+   * @note The dictionary a handle was resolved from must outlive it.
+   */
+  template <typename T>
+  class Handle {
+    //! Dictionary type along the path, const if T is const.
+    using DictionaryT =
+        std::conditional_t<std::is_const_v<T>, const Dictionary, Dictionary>;
+
+   public:
+    /*! Check whether the cached pointer is still up to date.
+     *
+     * @return true if no dictionary along the path has been structurally
+     *     modified since the handle was last resolved.
+     */
+    bool is_valid() const noexcept {
+      for (const auto &level : levels_) {
+        if (level.node->generation_ != level.generation) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /*! Get a reference to the value, resolving the path again if needed.
+     *
+     * @return Reference to the value.
+     *
+     * @throw KeyError if the path does not lead to an object any more.
+     * @throw TypeError if the object at the end of the path is not a value,
+     *     or it is but its type is not T.
+     */
+    T &get() {
+      if (!is_valid()) {
+        resolve_();
+      }
+      return *value_;
+    }
+
+    //! Dereference the handle, see @ref get.
+    T &operator*() { return get(); }
+
+    //! Access members of the value, see @ref get.
+    T *operator->() { return &get(); }
+
+    //! Path the handle resolves, with keys separated by slashes.
+    const std::string &path() const noexcept { return path_; }
+
+   private:
+    //! Dictionary along the path, with its generation at resolution time.
+    struct Level {
+      //! Dictionary along the path.
+      const Dictionary *node;
+
+      //! Generation of the dictionary when the handle was resolved.
+      std::uint64_t generation;
+    };
+
+    //! Key along the path, given by its position in the path string.
+    struct Segment {
+      //! Offset of the key in the path string.
+      size_t offset;
+
+      //! Length of the key.
+      size_t size;
+
+      //! Hash of the key.
+      std::uint64_t hash;
+    };
+
+    friend class Dictionary;
+
+    /*! Resolve a path for the first time.
+     *
+     * @param[in] root Dictionary to resolve the path from.
+     * @param[in] path Keys separated by slashes.
+     */
+    Handle(DictionaryT &root, std::string_view path)
+        : root_(&root), path_(path) {
+      size_t offset = 0;
+      while (offset <= path_.size()) {
+        size_t end = path_.find('/', offset);
+        if (end == std::string::npos) {
+          end = path_.size();
+        }
+        const std::string_view name(path_.data() + offset, end - offset);
+        segments_.push_back({offset, name.size(), internal::fnv1a(name)});
+        offset = end + 1;
+      }
+      levels_.reserve(segments_.size() + 1);
+      resolve_();
+    }
+
+    //! Walk the path from the root dictionary and cache the value pointer.
+    void resolve_() {
+      levels_.clear();
+      DictionaryT *node = root_;
+      for (const auto &segment : segments_) {
+        levels_.push_back({node, node->generation_});
+        const std::string_view name(path_.data() + segment.offset,
+                                    segment.size);
+        if (node->is_value()) {
+          throw TypeError(__FILE__, __LINE__,
+                          "Cannot look up at key \"" + std::string(name) +
+                              "\" of path \"" + path_ +
+                              "\" in non-dictionary object of type \"" +
+                              node->value_.type_name() + "\".");
+        }
+        node = node->map_.find(name, segment.hash);
+        if (node == nullptr) {
+          throw exceptions::KeyError(std::string(name), __FILE__, __LINE__,
+                                     "Cannot resolve path \"" + path_ + "\".");
+        }
+      }
+      levels_.push_back({node, node->generation_});
+      value_ = &node->template as<std::remove_const_t<T>>();
+    }
+
+   private:
+    //! Dictionary the path is resolved from.
+    DictionaryT *root_;
+
+    //! Keys separated by slashes.
+    std::string path_;
+
+    //! Keys along the path.
+    std::vector<Segment> segments_;
+
+    //! Dictionaries along the path, from the root to the value.
+    std::vector<Level> levels_;
+
+    //! Cached pointer to the value.
+    T *value_ = nullptr;
   };
 
- public:
   //! Default constructor
   Dictionary() = default;
 
+  /*! Construct a dictionary whose values are allocated from a memory resource.
+   *
+   * @param[in] resource Memory resource used to allocate value buffers of
+   *     this dictionary and all its children, except for small values that
+   *     are stored inline. The resource must outlive the dictionary.
+   *
+   * Any std::pmr::memory_resource works. For instance, a
+   * std::pmr::monotonic_buffer_resource packs value buffers together in an
+   * arena and releases them all at once when the arena is released, while
+   * Eigen alignment requirements are preserved:
+   *
+   * @code{cpp}
+   * std::pmr::monotonic_buffer_resource arena(64 * 1024);
+   * Dictionary dict(&arena);
+   * dict("imu")("orientation") = Eigen::Quaterniond::Identity();
+   * @endcode
+   */
+  explicit Dictionary(std::pmr::memory_resource *resource) noexcept
+      : resource_(resource), map_(resource) {}
+
   //! No copy constructor
   Dictionary(const Dictionary &) = delete;
 
   //! No copy assignment operator
   Dictionary &operator=(const Dictionary &) = delete;
 
-  //! Default move constructor
-  Dictionary(Dictionary &&) = default;
+  /*! Move constructor.
+   *
+   * @param[in] other Dictionary to take the value and children from.
+   *
+   * @throw FrozenError if the other dictionary is part of a frozen tree but
+   *     is not its root.
+   */
+  Dictionary(Dictionary &&other)
+      : resource_(other.resource_),
+        arena_(std::move(other.arena_)),
+        frozen_(other.frozen_) {
+    if (other.frozen_ && !arena_) {
+      throw exceptions::FrozenError(
+          __FILE__, __LINE__,
+          "Cannot move a dictionary out of a frozen dictionary.");
+    }
+    value_ = std::move(other.value_);
+    map_ = std::move(other.map_);
+    other.frozen_ = false;
+    other.plan_.reset();
+    ++other.generation_;
+  }
 
-  //! Default move assignment operator
-  Dictionary &operator=(Dictionary &&) = default;
+  /*! Move assignment operator.
+   *
+   * @param[in] other Dictionary to take the value and children from.
+   *
+   * @throw FrozenError if this dictionary is frozen, or if the other
+   *     dictionary is part of a frozen tree but is not its root.
+   */
+  Dictionary &operator=(Dictionary &&other) {
+    if (this != &other) {
+      check_not_frozen_("move-assign to");
+      if (other.frozen_ && !other.arena_) {
+        throw exceptions::FrozenError(
+            __FILE__, __LINE__,
+            "Cannot move a dictionary out of a frozen dictionary.");
+      }
+      resource_ = other.resource_;
+      value_ = std::move(other.value_);
+      map_ = std::move(other.map_);
+      arena_ = std::move(other.arena_);
+      frozen_ = other.frozen_;
+      other.frozen_ = false;
+      plan_.reset();
+      other.plan_.reset();
+      ++generation_;
+      ++other.generation_;
+    }
+    return *this;
+  }
 
   /*! Default destructor.
    *
-   * @note Child dictionaries will be recursively destroyed as they are held by
-   * unique pointers in an unordered_map;
+   * @note Child dictionaries will be recursively destroyed as they are held
+   * by the internal flat map.
    */
   ~Dictionary() = default;
 
@@ -258,8 +793,15 @@ class Dictionary {
    * @param[in] key Key to look for.
    * @return true when the key is in the dictionary.
    */
-  bool has(const std::string &key) const noexcept {
-    return (map_.find(key) != map_.end());
+  bool has(std::string_view key) const noexcept { return has(Key(key)); }
+
+  /*! Check whether a key is in the dictionary.
+   *
+   * @param[in] key Key to look for, with precomputed hash.
+   * @return true when the key is in the dictionary.
+   */
+  bool has(const Key &key) const noexcept {
+    return (map_.find(key.name(), key.hash()) != nullptr);
   }
 
   //! Return the list of keys of the dictionary.
@@ -268,6 +810,118 @@ class Dictionary {
   //! Return the number of keys in the dictionary.
   unsigned size() const noexcept { return map_.size(); }
 
+  /*! Relocate the whole tree into a single contiguous block of memory.
+   *
+   * Keys, child tables and values are laid out depth-first in one arena owned
+   * by this dictionary, so that traversals such as @ref serialize or
+   * @ref update stream linearly through memory. Dynamic objects such as
+   * Eigen::VectorXd or std::string keep their own heap storage.
+   *
+   * Once frozen, values can be updated but the structure of the tree cannot:
+   * adding or removing keys, clearing, creating or replacing values throws a
+   * FrozenError until @ref thaw is called.
+   *
+   * @note References to child dictionaries and values taken before freezing
+   * are invalidated, while those taken after freezing stay valid until the
+   * dictionary is thawed. Handles resolve their path again automatically.
+   */
+  void freeze();
+
+  /*! Relocate the tree back to regular allocations after @ref freeze.
+   *
+   * @throw FrozenError if the dictionary is part of a frozen tree but is not
+   *     its root.
+   *
+   * @note References to child dictionaries and values are invalidated.
+   */
+  void thaw();
+
+  //! Check whether the dictionary is part of a frozen tree.
+  bool is_frozen() const noexcept { return frozen_; }
+
+  /*! Structural generation of the dictionary.
+   *
+   * @return Counter incremented whenever keys are added to or removed from
+   *     the dictionary, or when its value is created or replaced.
+   */
+  std::uint64_t generation() const noexcept { return generation_; }
+
+  //! Counters of the key-order caches used by updates.
+  struct KeyOrderStats {
+    //! Number of keys found at their predicted position.
+    std::uint64_t hits = 0;
+
+    //! Number of keys looked up in the map.
+    std::uint64_t misses = 0;
+
+    //! Ratio of hits over all keys, zero if no key was updated.
+    double hit_rate() const noexcept {
+      const std::uint64_t total = hits + misses;
+      return (total > 0) ? static_cast<double>(hits) / total : 0.0;
+    }
+  };
+
+  /*! Key-order cache counters of this dictionary and its descendants.
+   *
+   * @return Sum of the counters of all maps in the tree.
+   *
+   * Each map updated with @ref update or @ref stream_update records the
+   * sequence of keys of the last message along with the matching children.
+   * When the next message has its keys in the same order, which is the case
+   * for messages coming from the same producer, each key is then matched by
+   * comparing its bytes to the predicted one rather than by a map lookup.
+   */
+  KeyOrderStats key_order_stats() const noexcept;
+
+  /*! Memory resource that value buffers are allocated from.
+   *
+   * @return Memory resource, or nullptr if values use the default allocator.
+   */
+  std::pmr::memory_resource *memory_resource() const noexcept {
+    return resource_;
+  }
+
+  /*! Reserve capacity so that updates of the value do not allocate.
+   *
+   * @param[in] capacity Number of characters of a string, or of elements of
+   *     a standard vector, that updates can then write in place.
+   *
+   * @throw TypeError if the dictionary is not a value, or if the value has no
+   *     capacity. Eigen::VectorXd values have none beyond their size.
+   *
+   * Together with @ref set_resize_policy, this makes updates of dynamic values
+   * safe to run in real-time threads:
+   *
+   * @code{cpp}
+   * dict("name") = std::string();
+   * dict("name").reserve(64);
+   * dict("name").set_resize_policy(mpack::ResizePolicy::kTruncate);
+   * @endcode
+   */
+  void reserve(size_t capacity);
+
+  /*! Set what updates do with incoming lengths that do not fit values.
+   *
+   * @param[in] policy Resize policy, see @ref mpack::ResizePolicy.
+   *
+   * @throw TypeError if the dictionary is a value whose type has no resize
+   *     policy.
+   *
+   * If the dictionary is a map, the policy is set for all values of the tree
+   * that have one: strings, standard vectors and Eigen::VectorXd. Values
+   * created afterwards start with the default policy of their type.
+   */
+  void set_resize_policy(mpack::ResizePolicy policy);
+
+  /*! Get the resize policy of the value.
+   *
+   * @return What updates do with incoming lengths that do not fit the value.
+   *
+   * @throw TypeError if the dictionary is not a value, or if the value type
+   *     has no resize policy.
+   */
+  mpack::ResizePolicy resize_policy() const;
+
   /*! Get reference to the internal value.
    *
    * @return Reference to the object.
@@ -306,7 +960,20 @@ class Dictionary {
    * @throw TypeError if there is an object at this key, but its type is not T.
    */
   template <typename T>
-  T &get(const std::string &key) {
+  T &get(std::string_view key) {
+    return const_cast<T &>(get_<T>(Key(key)));
+  }
+
+  /*! Variant of @ref get for keys with precomputed hashes.
+   *
+   * @param[in] key Key to the object.
+   * @return Reference to the object.
+   *
+   * @throw KeyError if there is no object at this key.
+   * @throw TypeError if there is an object at this key, but its type is not T.
+   */
+  template <typename T>
+  T &get(const Key &key) {
     return const_cast<T &>(get_<T>(key));
   }
 
@@ -319,7 +986,20 @@ class Dictionary {
    * @throw TypeError if there is an object at this key, but its type is not T.
    */
   template <typename T>
-  const T &get(const std::string &key) const {
+  const T &get(std::string_view key) const {
+    return get_<T>(Key(key));
+  }
+
+  /*! Const variant of @ref get for keys with precomputed hashes.
+   *
+   * @param[in] key Key to the object.
+   * @return Reference to the object.
+   *
+   * @throw KeyError if there is no object at this key.
+   * @throw TypeError if there is an object at this key, but its type is not T.
+   */
+  template <typename T>
+  const T &get(const Key &key) const {
     return get_<T>(key);
   }
 
@@ -334,30 +1014,76 @@ class Dictionary {
    *     its type does is not T.
    */
   template <typename T>
-  const T &get(const std::string &key, const T &default_value) const {
-    auto it = map_.find(key);
-    if (it != map_.end()) {
-      if (it->second->is_map()) {
+  const T &get(std::string_view key, const T &default_value) const {
+    return get<T>(Key(key), default_value);
+  }
+
+  /*! Variant of @ref get with default value for keys with precomputed hashes.
+   *
+   * @param[in] key Key to look for.
+   * @param[in] default_value Default value used if there is no value at this
+   * key.
+   * @return Reference to the object if it exists, default_value otherwise.
+   *
+   * @throw TypeError if the object at this key is not a value, or it is but
+   *     its type does is not T.
+   */
+  template <typename T>
+  const T &get(const Key &key, const T &default_value) const {
+    const Dictionary *child = map_.find(key.name(), key.hash());
+    if (child != nullptr) {
+      if (child->is_map()) {
         throw TypeError(__FILE__, __LINE__,
-                        "Object at key \"" + key +
+                        "Object at key \"" + std::string(key.name()) +
                             "\" is a dictionary, cannot get a single value "
                             "from it. Did you "
                             "mean to use operator()?");
       }
       try {
-        return it->second->value_.get_reference<T>();
+        return child->value_.get_reference<T>();
       } catch (const TypeError &e) {
         throw TypeError(
             __FILE__, __LINE__,
-            "Object for key \"" + key +
+            "Object for key \"" + std::string(key.name()) +
                 "\" does not have the same type as the stored type. Stored " +
-                it->second->value_.type_name() + " but requested " +
+                child->value_.type_name() + " but requested " +
                 typeid(T).name() + ".");
       }
     }
     return default_value;
   }
 
+  /*! Resolve a path to a value once, for repeated access.
+   *
+   * @param[in] path Keys separated by slashes, for instance
+   *     ``"bodies/plane/position"``.
+   * @return Handle caching a pointer to the value.
+   *
+   * @throw KeyError if there is no object at this path.
+   * @throw TypeError if there is an object at this path but it is not a
+   *     value, or its type is not T.
+   *
+   * See @ref Handle for details.
+   */
+  template <typename T>
+  Handle<T> resolve(std::string_view path) {
+    return Handle<T>(*this, path);
+  }
+
+  /*! Const variant of @ref resolve.
+   *
+   * @param[in] path Keys separated by slashes.
+   * @return Handle caching a const pointer to the value.
+   *
+   * @throw KeyError if there is no object at this path.
+   * @throw TypeError if there is an object at this path but it is not a
+   *     value, or its type is not T.
+   */
+  template <typename T>
+  Handle<const T> resolve(std::string_view path) const {
+    return Handle<const T>(*this, path);
+  }
+
   /*! Create an object at a given key and return a reference to it. If there is
    * already a value at this key, return the existing object instead.
    *
@@ -374,10 +1100,10 @@ class Dictionary {
    * Also it doesn't return an insertion confirmation boolean.
    */
   template <typename T, typename... ArgsT, typename... Args>
-  T &insert(const std::string &key, Args &&...args) {
+  T &insert(std::string_view key, Args &&...args) {
     if (this->is_value()) {
       throw TypeError(__FILE__, __LINE__,
-                      "Cannot insert at key \"" + key +
+                      "Cannot insert at key \"" + std::string(key) +
                           "\" in non-dictionary object of type \"" +
                           value_.type_name() + "\".");
     }
@@ -389,9 +1115,11 @@ class Dictionary {
           key);
       return get<T>(key);
     }
-    child.value_.allocate<T>();
-    new (child.value_.buffer.get()) T(std::forward<Args>(args)...);
+    child.check_not_frozen_("insert a value in");
+    child.value_.allocate<T>(resource_);
+    new (child.value_.buffer) T(std::forward<Args>(args)...);
     T &ret = child.value_.setup<T, ArgsT...>();
+    ++child.generation_;
     return ret;
   }
 
@@ -407,7 +1135,7 @@ class Dictionary {
    */
   template <typename T>
   Dictionary &operator=(const T &new_value) {
-    if (this->is_map()) {
+    if (this->is_map() && !this->is_empty()) {
       clear();
     }
     if (this->is_empty()) {
@@ -435,11 +1163,16 @@ class Dictionary {
   /*! Remove a key-value pair from the dictionary.
    *
    * @param[in] key Key to remove.
+   *
+   * @throw FrozenError if the dictionary is frozen.
    */
-  void remove(const std::string &key) noexcept;
+  void remove(std::string_view key);
 
-  //! Remove all entries from the dictionary.
-  void clear() noexcept;
+  /*! Remove all entries from the dictionary.
+   *
+   * @throw FrozenError if the dictionary is frozen.
+   */
+  void clear();
 
   /*! Return a reference to the dictionary at key, performing an insertion if
    * such a key does not already exist.
@@ -468,7 +1201,18 @@ class Dictionary {
    * With operator[], these conversions would be ambiguous as [] is commutative
    * in C (c_str[int] == *(c_str + int) == int[c_str]).
    */
-  Dictionary &operator()(const std::string &key);
+  Dictionary &operator()(std::string_view key);
+
+  /*! Variant of @ref operator() for keys with precomputed hashes.
+   *
+   * @param[in] key Key to look at.
+   * @return Reference to the new dictionary at this key if there was none, or
+   *     to the existing dictionary otherwise.
+   *
+   * @throw TypeError if the dictionary is not a map, and therefore we cannot
+   *     look up a key from it.
+   */
+  Dictionary &operator()(const Key &key);
 
   /*! Return a reference to the dictionary at key, performing an insertion if
    * such a key does not already exist.
@@ -484,19 +1228,215 @@ class Dictionary {
    * operator will throw if the key is not already in the dictionary. See the
    * documentation for the non-const variant of this operator.
    */
-  const Dictionary &operator()(const std::string &key) const;
+  const Dictionary &operator()(std::string_view key) const;
+
+  /*! Const variant of @ref operator() for keys with precomputed hashes.
+   *
+   * @param[in] key Key to look at.
+   * @return Reference to the dictionary at this key.
+   *
+   * @throw KeyError if there is no object at this key.
+   * @throw TypeError if the dictionary is not a map, and therefore we cannot
+   *     lookup a key from it.
+   */
+  const Dictionary &operator()(const Key &key) const;
 
   /*! Serialize to raw MessagePack data.
    *
    * @param[out] buffer Buffer that will hold the message data.
    * @return Size of the message. Note that it is not the same as
    *     the size of the buffer after execution.
+   *
+   * @throw PalimpsestError if MPack flags an error while writing the
+   *     message, for instance if the buffer fails to grow.
+   *
+   * The first call compiles a serialization plan that holds pre-encoded map
+   * headers and keys. Subsequent calls copy these bytes and only encode
+   * values, until the structure of the dictionary changes and the plan is
+   * compiled again.
+   *
+   * @note Since the plan is cached in the dictionary, concurrent calls to
+   * this function on the same dictionary are not thread-safe.
    */
   size_t serialize(std::vector<char> &buffer) const;
 
+  /*! Serialize to raw MessagePack data with a reusable writer.
+   *
+   * @param[out] writer Writer to serialize to. It is reset first, so that
+   *     the same writer can be passed to every call.
+   * @return Size of the message, which starts at @c writer.data().
+   *
+   * @throw PalimpsestError if MPack flags an error while writing the
+   *     message, for instance if the buffer fails to grow.
+   *
+   * Unlike @ref serialize(std::vector<char>&), this function does not
+   * initialize a new writer on each call. With a writer that owns its
+   * buffer, the buffer keeps its grown capacity and is never zero-filled, so
+   * that serializing messages of a steady size does not allocate.
+   *
+   * Dense Eigen vectors and matrices are encoded according to the
+   * @ref mpack::Writer::array_encoding of the writer. Binary blobs are much
+   * faster to encode and decode for large vectors, and all update functions
+   * of dictionaries decode them.
+   */
+  size_t serialize(mpack::Writer &writer) const;
+
+  //! Result of a serialization to a fixed-capacity buffer.
+  struct SerializeResult {
+    //! Size of the message written to the buffer, zero if it did not fit.
+    size_t size = 0;
+
+    //! Capacity the message needs.
+    size_t required_size = 0;
+
+    //! Check whether the buffer was too small to hold the message.
+    bool insufficient_capacity() const noexcept {
+      return size < required_size;
+    }
+  };
+
+  /*! Serialize to raw MessagePack data in caller-provided memory.
+   *
+   * @param[out] data Memory to write the message to, for instance a
+   *     preallocated shared-memory region.
+   * @param[in] capacity Number of bytes available at @p data.
+   * @return Size of the message if it fits, otherwise the capacity it needs.
+   *
+   * @throw PalimpsestError if MPack flags an error while writing the
+   *     message. Messages that do not fit are not errors.
+   *
+   * This function never writes past @p capacity, and does not allocate
+   * once the serialization plan is compiled (see @ref serialize). When the
+   * message does not fit, the contents of @p data are unspecified: call it
+   * again with at least @c required_size bytes.
+   */
+  SerializeResult serialize(char *data, size_t capacity) const;
+
+  /*! Serialized values of the last frame of a delta serialization.
+   *
+   * A baseline is filled by @ref serialize_delta and belongs to the
+   * dictionary it was last passed with: passing it with another dictionary
+   * starts a new sequence of deltas.
+   */
+  class DeltaBaseline {
+   public:
+    //! Forget the last frame, so that the next delta holds every value.
+    void reset() noexcept {
+      root_ = nullptr;
+      nodes_.clear();
+    }
+
+    //! Check whether the baseline holds a frame.
+    bool empty() const noexcept { return root_ == nullptr; }
+
+    /*! Check whether the next delta of a dictionary only holds changes.
+     *
+     * @param[in] dict Dictionary to serialize.
+     * @return False if the baseline is empty, belongs to another dictionary,
+     *     or if keys were added to or removed from the tree since the last
+     *     frame: the next delta of @p dict then holds every value.
+     */
+    bool is_valid_for(const Dictionary &dict) const noexcept;
+
+   private:
+    friend class Dictionary;
+
+    //! Dictionary in the tree, in depth-first order.
+    struct Node {
+      //! Dictionary in the tree.
+      const Dictionary *node;
+
+      //! Generation of the dictionary in the last frame.
+      std::uint64_t generation;
+
+      //! Index of the node after the subtree of this one.
+      size_t end;
+
+      //! Offset of the serialized value in the last frame, if a value.
+      size_t offset;
+
+      //! Size of the serialized value in the last frame, if a value.
+      size_t size;
+
+      //! Whether the value, or a value in the subtree, changed.
+      bool changed;
+    };
+
+    //! Root of the tree the baseline was filled from, or nullptr.
+    const Dictionary *root_ = nullptr;
+
+    //! Dictionaries of the tree, in depth-first order.
+    std::vector<Node> nodes_;
+
+    //! Serialized values of the last frame.
+    std::vector<char> bytes_;
+
+    //! Serialized values of the frame being written.
+    std::vector<char> next_bytes_;
+  };
+
+  /*! Serialize only the values that changed since the last frame.
+   *
+   * @param[out] buffer Buffer that will hold the message data.
+   * @param[in, out] baseline Serialized values of the last frame, replaced
+   *     by those of this frame.
+   * @return Size of the message.
+   *
+   * @throw PalimpsestError if MPack flags an error while writing the
+   *     message, for instance if the buffer fails to grow.
+   *
+   * The message is a nested map that only holds the values whose serialized
+   * bytes differ from those in the baseline, along with the keys of the maps
+   * leading to them. Since @ref update leaves keys that are not in a message
+   * untouched, applying each delta to a dictionary that holds the previous
+   * frame reproduces the current one.
+   *
+   * The first delta of a baseline, and the first one after keys are added to
+   * or removed from the tree, hold every value.
+   *
+   * @note Removed keys do not appear in deltas: consumers keep their last
+   * value.
+   */
+  size_t serialize_delta(std::vector<char> &buffer,
+                         DeltaBaseline &baseline) const;
+
+  /*! Serialize only the values that changed to caller-provided memory.
+   *
+   * @param[out] data Memory to write the message to.
+   * @param[in] capacity Number of bytes available at @p data.
+   * @param[in, out] baseline Serialized values of the last frame, replaced
+   *     by those of this frame.
+   * @return Size of the message if it fits, otherwise the capacity it needs.
+   *
+   * @throw PalimpsestError if MPack flags an error while writing the
+   *     message. Messages that do not fit are not errors.
+   *
+   * See @ref serialize_delta(std::vector<char>&, DeltaBaseline&). The
+   * baseline is replaced even if the message does not fit: reset it before
+   * the next call if the message is discarded.
+   */
+  SerializeResult serialize_delta(char *data, size_t capacity,
+                                  DeltaBaseline &baseline) const;
+
+  /*! Exact size of the MessagePack serialization, without encoding it.
+   *
+   * @return Number of bytes @ref serialize writes.
+   *
+   * The size of map headers, keys and values whose type has a fixed
+   * serialized size (such as double or Eigen::Vector3d) is cached in the
+   * serialization plan. Only values of variable size, such as integers,
+   * strings or dynamic vectors, are inspected on each call.
+   *
+   * @note This is the size with the default array encoding of Eigen types.
+   */
+  size_t serialized_size() const;
+
   /*! Write MessagePack serialization to a binary file.
    *
    * @param[in] filename Path to the output file.
+   *
+   * @throw PalimpsestError if MPack flags an error while writing the
+   *     message, for instance if the buffer fails to grow.
    */
   void write(const std::string &filename) const;
 
@@ -516,6 +1456,19 @@ class Dictionary {
    */
   void update(const char *data, size_t size);
 
+  /*! Update dictionary from raw MessagePack data, reusing a parser.
+   *
+   * @param[in] data Buffer to read MessagePack from.
+   * @param[in] size Buffer size.
+   * @param[in, out] parser Parser whose node pool is used to parse the
+   *     message. Reusing the same parser across calls avoids allocating a new
+   *     tree for each message.
+   *
+   * @throw TypeError if deserialized data types don't match those of the
+   *     corresponding objects in the dictionary.
+   */
+  void update(const char *data, size_t size, mpack::Parser &parser);
+
   /*! Update existing values from an MPack node.
    *
    * @param[in] node MPack node. Its key-values should match those of the
@@ -527,6 +1480,41 @@ class Dictionary {
    */
   void update(mpack_node_t node);
 
+  /*! Update dictionary from raw MessagePack data, streaming through it once.
+   *
+   * @param[in] data Buffer to read MessagePack from.
+   * @param[in] size Buffer size.
+   *
+   * @throw TypeError if deserialized data types don't match those of the
+   *     corresponding objects in the dictionary.
+   *
+   * Contrary to @ref update(const char *, size_t), this function does not
+   * parse the message into an MPack tree first: it reads values as they come
+   * and writes them directly to existing objects, so that updating existing
+   * keys does not allocate. Keys that are not in the dictionary yet are
+   * inserted as in @ref update.
+   *
+   * @note Since the message is not validated before it is applied, values
+   *     that precede an error in the message are updated.
+   */
+  void stream_update(const char *data, size_t size);
+
+  /*! Update existing values from an MPack reader.
+   *
+   * @param[in, out] reader MPack reader positioned at the start of the
+   *     object to read. It must read from memory, as initialized by
+   *     @c mpack_reader_init_data: new keys are parsed again from the bytes
+   *     of their values, which a reader with a fill function does not keep.
+   *
+   * @throw PalimpsestError if the reader has a fill function, or if the
+   *     value of a new key cannot be parsed.
+   * @throw TypeError if a deserialized object's type does not match the type
+   *     of an existing entry in the dictionary.
+   *
+   * Errors in the message itself are flagged on the reader.
+   */
+  void update(mpack_reader_t *reader);
+
   //! Allow implicit conversion to (bool &).
   operator bool &() { return this->as<bool>(); }
 
@@ -651,12 +1639,145 @@ class Dictionary {
   template <typename T, typename... ArgsT, typename... Args>
   void become(Args &&...args) {
     assert(this->is_empty());
-    value_.allocate<T>();
-    new (value_.buffer.get()) T(std::forward<Args>(args)...);
+    check_not_frozen_("create a value in");
+    value_.allocate<T>(resource_);
+    new (value_.buffer) T(std::forward<Args>(args)...);
     value_.setup<T, ArgsT...>();
+    ++generation_;
   }
 
  private:
+  /*! Serialization plan: pre-encoded bytes interleaved with values.
+   *
+   * Serializing a dictionary with a plan amounts to copying the bytes of each
+   * step, then serializing its value if any. The plan records the generation
+   * of every dictionary in the tree, in depth-first order, so that it can
+   * check that the structure of the tree has not changed since.
+   */
+  struct SerializationPlan {
+    //! Pre-encoded bytes, followed by a value to serialize if any.
+    struct Step {
+      //! Offset of the pre-encoded bytes.
+      size_t offset;
+
+      //! Number of pre-encoded bytes.
+      size_t size;
+
+      //! Value to serialize after the bytes, or nullptr.
+      const Value *value;
+    };
+
+    //! Dictionary in the tree, with its generation at compile time.
+    struct Record {
+      //! Dictionary in the tree.
+      const Dictionary *node;
+
+      //! Generation of the dictionary when the plan was compiled.
+      std::uint64_t generation;
+    };
+
+    /*! Check whether the structure of the tree is unchanged.
+     *
+     * @note Records are checked parent-first, so that a removed child is
+     * never dereferenced: its parent's generation has changed.
+     */
+    bool is_valid() const noexcept {
+      for (const auto &record : records) {
+        if (record.node->generation_ != record.generation) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    //! Encoded map headers and keys.
+    std::vector<char> bytes;
+
+    //! Serialization steps.
+    std::vector<Step> steps;
+
+    //! Generations of dictionaries in the tree, in depth-first order.
+    std::vector<Record> records;
+
+    //! Size of the pre-encoded bytes and of fixed-size values.
+    size_t fixed_size = 0;
+
+    //! Values whose serialized size depends on their contents.
+    std::vector<const Value *> variable_values;
+  };
+
+  /*! Sequence of keys of the last update, with the matching children.
+   *
+   * Children are only valid for the generation the sequence was recorded at:
+   * the sequence is reset when the generation of the dictionary changes.
+   */
+  struct KeyOrder {
+    //! Predicted key at a given position in the message.
+    struct Entry {
+      //! Offset of the key in @ref keys.
+      size_t offset;
+
+      //! Size of the key.
+      size_t size;
+
+      //! Child at this key.
+      Dictionary *child;
+    };
+
+    //! Generation of the dictionary when the sequence was recorded.
+    std::uint64_t generation = 0;
+
+    //! Predicted keys, in message order.
+    std::vector<Entry> entries;
+
+    //! Concatenated bytes of the predicted keys.
+    std::vector<char> keys;
+
+    //! Cache counters.
+    KeyOrderStats stats;
+  };
+
+  /*! Find the child at a key of the message being updated.
+   *
+   * @param[in] index Position of the key in the message.
+   * @param[in] key Key of the child.
+   * @return Child at this key, or nullptr if there is none.
+   *
+   * The key is first compared to the one predicted by the key-order cache at
+   * this position. On a mismatch, the child is looked up in the map and the
+   * cache records the new sequence from this position.
+   */
+  Dictionary *find_update_child_(size_t index, std::string_view key);
+
+  /*! Throw if the dictionary is frozen.
+   *
+   * @param[in] action Structural modification, for the error message.
+   *
+   * @throw FrozenError if the dictionary is frozen.
+   */
+  void check_not_frozen_(const char *action) const {
+    if (frozen_) {
+      throw exceptions::FrozenError(
+          __FILE__, __LINE__,
+          std::string("Cannot ") + action +
+              " a frozen dictionary. Call thaw() on its root first.");
+    }
+  }
+
+  /*! Upper bound on the arena size needed to freeze the tree.
+   *
+   * @return Number of bytes, including alignment padding.
+   */
+  size_t frozen_bytes_() const;
+
+  /*! Move the tree to another dictionary, laying it out depth-first.
+   *
+   * @param[out] target Empty dictionary to move the tree to.
+   * @param[in] arena Arena to allocate the tree from when freezing, or
+   *     nullptr to use the memory resource of each dictionary when thawing.
+   */
+  void relocate_(Dictionary &target, std::pmr::memory_resource *arena);
+
   /*! Get a const reference to the object at a given key.
    *
    * @param[in] key Key to the object.
@@ -666,13 +1787,14 @@ class Dictionary {
    * @throw TypeError if there is an object at this key, but its type is not T.
    */
   template <typename T>
-  const T &get_(const std::string &key) const {
+  const T &get_(const Key &key) const {
     const auto &child_value = get_child_value_(key);
     try {
       return child_value.get_reference<T>();
     } catch (const TypeError &e) {
       throw TypeError(__FILE__, __LINE__,
-                      "Object at key \"" + key + "\" has type \"" +
+                      "Object at key \"" + std::string(key.name()) +
+                          "\" has type \"" +
                           child_value.type_name() +
                           "\", but is being cast to type \"" +
                           typeid(T).name() + "\".");
@@ -687,7 +1809,7 @@ class Dictionary {
    * @throw KeyError if there is no object at this key.
    * @throw TypeError if there is an object at this key but it is not a value.
    */
-  const Value &get_child_value_(const std::string &key) const;
+  const Value &get_child_value_(const Key &key) const;
 
   /*! Deserialize an MPack value at a given key.
    *
@@ -696,22 +1818,142 @@ class Dictionary {
    *
    * @throw TypeError if the type of the deserialized object cannot be handled.
    */
-  void insert_at_key_(const std::string &key, const mpack_node_t &value);
+  void insert_at_key_(std::string_view key, const mpack_node_t &value);
+
+  /*! Deserialize a binary blob of an Eigen array at a given key.
+   *
+   * @param[in] key Key to store the deserialized object at.
+   * @param[in] data Binary blob, see @ref mpack::ArrayEncoding.
+   * @param[in] size Number of bytes of the blob.
+   *
+   * @throw TypeError if the blob is malformed or its shape is not that of a
+   *     supported Eigen type.
+   */
+  void insert_binary_at_key_(std::string_view key, const char *data,
+                             size_t size);
+
+  /*! Deserialize the next value of an MPack reader at a given key.
+   *
+   * @param[in] key Key to store the deserialized object at.
+   * @param[in, out] reader MPack reader positioned at the value.
+   *
+   * @throw TypeError if the type of the deserialized object cannot be handled.
+   *
+   * The value is skipped in the stream, then its bytes are parsed as an MPack
+   * tree to infer its type. This is the slow path of
+   * @ref update(mpack_reader_t *), which only accepts readers from memory.
+   *
+   * @throw PalimpsestError if the value cannot be parsed as a tree.
+   */
+  void insert_at_key_(std::string_view key, mpack_reader_t *reader);
 
   /*! Serialize to a MessagePack writer.
    *
    * @param[out] writer Writer to serialize to.
+   *
+   * This function uses the serialization plan, compiling it if needed,
+   * unless MPACK_WRITE_TRACKING is enabled.
    */
   void serialize_(mpack::Writer &writer) const;
 
+  /*! Serialize to a MessagePack writer, encoding keys and map headers.
+   *
+   * @param[out] writer Writer to serialize to.
+   */
+  void serialize_tree_(mpack::Writer &writer) const;
+
+  //! Compute the serialized size without the serialization plan.
+  size_t serialized_size_tree_() const;
+
+  //! Compile the serialization plan of the dictionary.
+  void compile_plan_() const;
+
+  /*! Append the dictionary to a serialization plan being compiled.
+   *
+   * @param[out] writer Writer encoding map headers and keys.
+   * @param[out] plan Plan being compiled.
+   * @param[in, out] offset Offset of the bytes of the current step.
+   */
+  void compile_(mpack::Writer &writer, SerializationPlan &plan,
+                size_t &offset) const;
+
+  /*! Replace the values of a delta baseline by those of the tree.
+   *
+   * @param[in, out] baseline Baseline to update, whose nodes are then
+   *     marked as changed or not.
+   */
+  void update_delta_baseline_(DeltaBaseline &baseline) const;
+
+  /*! Record the tree in a delta baseline and serialize its values.
+   *
+   * @param[out] writer Writer the values are serialized to, one after the
+   *     other.
+   * @param[in, out] baseline Baseline the nodes are appended to.
+   */
+  void record_delta_(mpack::Writer &writer, DeltaBaseline &baseline) const;
+
+  /*! Serialize the values of the tree and compare them to the baseline.
+   *
+   * @param[out] writer Writer the values are serialized to, one after the
+   *     other.
+   * @param[in, out] baseline Baseline holding the same tree.
+   * @param[in, out] index Index of the dictionary in the baseline nodes,
+   *     advanced past its subtree.
+   * @return True if a value in the tree changed.
+   */
+  bool compare_delta_(mpack::Writer &writer, DeltaBaseline &baseline,
+                      size_t &index) const;
+
+  /*! Write the changed values of the tree.
+   *
+   * @param[out] writer Writer to serialize to.
+   * @param[in] baseline Baseline whose nodes are marked as changed or not.
+   * @param[in] index Index of the dictionary in the baseline nodes.
+   */
+  void write_delta_(mpack::Writer &writer, const DeltaBaseline &baseline,
+                    size_t index) const;
+
  protected:
+  //! Memory resource for value buffers, nullptr for the default allocator.
+  std::pmr::memory_resource *resource_ = nullptr;
+
+  //! Arena holding the tree if we are the root of a frozen tree.
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+
   //! Internal value, used if we are a value.
   Value value_;
 
   //! Key-value map, used if we are a map.
-  std::unordered_map<std::string, std::unique_ptr<Dictionary>> map_;
+  internal::FlatMap<Dictionary> map_;
+
+  //! Structural generation, see @ref generation.
+  std::uint64_t generation_ = 0;
+
+  //! Whether the dictionary is part of a frozen tree.
+  bool frozen_ = false;
+
+  //! Serialization plan, compiled on demand by @ref serialize_.
+  mutable std::unique_ptr<SerializationPlan> plan_;
+
+  //! Key-order cache, created by the first update of the map.
+  std::unique_ptr<KeyOrder> key_order_;
 };
 
+namespace literals {
+
+/*! Build a dictionary key, hashed at compile time.
+ *
+ * @param[in] name Characters of the string literal.
+ * @param[in] size Number of characters.
+ * @return Key with precomputed hash.
+ */
+constexpr Dictionary::Key operator""_key(const char *name,
+                                         std::size_t size) noexcept {
+  return Dictionary::Key(std::string_view(name, size));
+}
+
+}  // namespace literals
+
 }  // namespace palimpsest
 
 namespace fmt {
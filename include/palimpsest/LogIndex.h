@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace palimpsest {
+
+/*! Index of the frames of a log file, appended to the file as it is written.
+ *
+ * Logs are concatenations of MessagePack frames. An indexed log interleaves
+ * them with index blocks, and ends with a footer:
+ *
+ * - Each index block lists the offsets and sizes of the frames written since
+ *   the previous block.
+ * - The footer lists the first frame and offset of every block, and ends
+ *   with its own offset, so that readers find it from the end of the file.
+ *
+ * Blocks and footers are MessagePack binary objects (bin 32) whose payload
+ * starts with a magic string. MessagePack readers therefore still parse
+ * indexed logs, and only need to skip objects that are not maps. All
+ * integers in payloads are little-endian 64-bit unsigned integers:
+ *
+ * | Object | Payload                                                       |
+ * |--------|---------------------------------------------------------------|
+ * | Block  | @ref kBlockMagic, first frame, number of frames, then the     |
+ * |        | offset and size of each frame                                 |
+ * | Footer | @ref kFooterMagic, number of frames, number of blocks, then   |
+ * |        | the first frame and offset of each block, then the offset of  |
+ * |        | the footer and @ref kFooterMagic again                        |
+ *
+ * Offsets are those of the first byte of an object in the file.
+ *
+ * Logs may also hold delta frames, which only hold the values that changed
+ * since the previous frame (see @ref Dictionary::serialize_delta). Each delta
+ * frame is preceded by @ref kDeltaMarker, a binary object (bin 8) as well,
+ * while frames without a marker are keyframes that hold every value.
+ */
+class LogIndex {
+ public:
+  //! Magic string at the beginning of index blocks.
+  static constexpr char kBlockMagic[8] = {'p', 'l', 'm', 'p',
+                                          'i', 'd', 'x', 'b'};
+
+  //! Magic string at the beginning and at the end of footers.
+  static constexpr char kFooterMagic[8] = {'p', 'l', 'm', 'p',
+                                           'i', 'd', 'x', 'f'};
+
+  //! Binary object written before each delta frame.
+  static constexpr char kDeltaMarker[10] = {'\xc4', 8,   'p', 'l', 'm',
+                                            'p',    'd', 'e', 'l', 't'};
+
+  //! Size of the MessagePack header of blocks and footers.
+  static constexpr size_t kHeaderSize = 5;
+
+  //! Size of the offset and magic string at the end of footers.
+  static constexpr size_t kTrailerSize = 16;
+
+  /*! Read a little-endian 64-bit unsigned integer.
+   *
+   * @param[in] data Bytes of the integer.
+   */
+  static std::uint64_t load(const char *data) noexcept {
+    std::uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+      value = (value << 8) | static_cast<unsigned char>(data[i]);
+    }
+    return value;
+  }
+
+  /*! Create an empty index.
+   *
+   * @param[in] interval Minimum number of frames per block.
+   */
+  explicit LogIndex(size_t interval) : interval_(interval) {}
+
+  /*! Record a frame appended to the log.
+   *
+   * @param[in] offset Offset of the frame in the file.
+   * @param[in] size Size of the frame in bytes.
+   */
+  void add_frame(std::uint64_t offset, std::uint64_t size) {
+    pending_.push_back({offset, size});
+  }
+
+  //! Check whether enough frames are pending to write a block.
+  bool has_full_block() const noexcept {
+    return pending_.size() >= interval_;
+  }
+
+  //! Number of frames recorded so far.
+  std::uint64_t nb_frames() const noexcept {
+    return nb_indexed_frames_ + pending_.size();
+  }
+
+  /*! Encode an index block of the pending frames.
+   *
+   * @param[in] offset Offset in the file where the block will be written.
+   * @param[out] bytes Buffer the block is appended to.
+   */
+  void write_block(std::uint64_t offset, std::vector<char> &bytes);
+
+  /*! Encode the last index block, if frames are pending, and the footer.
+   *
+   * @param[in] offset Offset in the file where the bytes will be written.
+   * @param[out] bytes Buffer the block and footer are appended to.
+   */
+  void write_footer(std::uint64_t offset, std::vector<char> &bytes);
+
+ private:
+  //! Offset and size of a frame, or first frame and offset of a block.
+  struct Entry {
+    //! Offset of a frame, or first frame of a block.
+    std::uint64_t first;
+
+    //! Size of a frame, or offset of a block.
+    std::uint64_t second;
+  };
+
+  //! Minimum number of frames per block.
+  size_t interval_;
+
+  //! Number of frames in blocks written so far.
+  std::uint64_t nb_indexed_frames_ = 0;
+
+  //! Frames recorded since the last block.
+  std::vector<Entry> pending_;
+
+  //! Blocks written so far.
+  std::vector<Entry> blocks_;
+};
+
+}  // namespace palimpsest
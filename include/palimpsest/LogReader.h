@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "palimpsest/Dictionary.h"
+#include "palimpsest/exceptions/SystemError.h"
+
+namespace palimpsest {
+
+/*! Random access to the frames of a log file.
+ *
+ * The file is mapped to memory, and frames are read in place:
+ *
+ * @code{cpp}
+ * LogReader log("upkie.mpack");
+ * Dictionary observation;
+ * log.read(log.nb_frames() / 2, observation);
+ * @endcode
+ *
+ * Indexed logs (see @ref LogIndex) are opened by checking their footer and
+ * the headers of their index blocks, without parsing frames. A frame is then
+ * found by a binary search over the blocks of the footer. Other logs,
+ * such as plain concatenations of MessagePack frames or indexed logs whose
+ * writer stopped before writing the footer, are scanned once when they are
+ * opened, skipping index blocks, delta markers and a truncated last frame if
+ * any. Logs with delta frames are read with @ref replay.
+ */
+class LogReader {
+ public:
+  /*! Open a log file.
+   *
+   * @param[in] path Path to the log file.
+   *
+   * @throw SystemError if the file cannot be opened or mapped.
+   */
+  explicit LogReader(const std::string &path);
+
+  //! Unmap the file.
+  ~LogReader();
+
+  //! Readers own their mapping, they cannot be copied.
+  LogReader(const LogReader &) = delete;
+
+  //! Readers own their mapping, they cannot be copied.
+  LogReader &operator=(const LogReader &) = delete;
+
+  //! Number of frames in the log.
+  size_t nb_frames() const noexcept { return nb_frames_; }
+
+  //! Whether frames are looked up from the footer of an indexed log.
+  bool is_indexed() const noexcept { return footer_ != nullptr; }
+
+  /*! Get the MessagePack bytes of a frame.
+   *
+   * @param[in] index Index of the frame, from zero.
+   * @return Bytes of the frame in the mapped file.
+   *
+   * @throw std::out_of_range if there is no frame at this index.
+   */
+  std::string_view frame(size_t index) const;
+
+  /*! Update a dictionary from a frame.
+   *
+   * @param[in] index Index of the frame, from zero.
+   * @param[in, out] dict Dictionary to update.
+   *
+   * @throw std::out_of_range if there is no frame at this index.
+   * @throw TypeError if deserialized data types don't match those of the
+   *     dictionary.
+   */
+  void read(size_t index, Dictionary &dict) const {
+    const std::string_view bytes = frame(index);
+    dict.update(bytes.data(), bytes.size());
+  }
+
+  /*! Check whether a frame holds every value of its dictionary.
+   *
+   * @param[in] index Index of the frame, from zero.
+   * @return False if the frame is a delta frame, preceded by
+   *     @ref LogIndex::kDeltaMarker, true otherwise.
+   *
+   * @throw std::out_of_range if there is no frame at this index.
+   */
+  bool is_keyframe(size_t index) const;
+
+  /*! Reconstruct a frame of a log that may hold delta frames.
+   *
+   * @param[in] index Index of the frame, from zero.
+   * @param[in, out] dict Dictionary to update.
+   *
+   * The dictionary is updated from the last keyframe at or before this index,
+   * then from each following frame up to this one. Its values are therefore
+   * those of the frame whether or not the log holds delta frames, at a cost
+   * bounded by the keyframe interval of the logger (see
+   * @ref Logger::set_delta_encoding).
+   *
+   * @throw std::out_of_range if there is no frame at this index.
+   * @throw TypeError if deserialized data types don't match those of the
+   *     dictionary.
+   */
+  void replay(size_t index, Dictionary &dict) const;
+
+ private:
+  /*! Find the footer of an indexed log.
+   *
+   * @return True if the file ends with a valid footer.
+   */
+  bool load_footer_();
+
+  //! Record the offsets and sizes of all frames by parsing the file.
+  void scan_();
+
+ private:
+  //! Path to the log file.
+  std::string path_;
+
+  //! Beginning of the mapped file, nullptr if the file is empty.
+  const char *data_ = nullptr;
+
+  //! Number of bytes of the file.
+  size_t size_ = 0;
+
+  //! Number of frames in the log.
+  size_t nb_frames_ = 0;
+
+  //! Block table of the footer of an indexed log, nullptr otherwise.
+  const char *footer_ = nullptr;
+
+  //! Number of blocks in the footer.
+  size_t nb_blocks_ = 0;
+
+  //! Offsets and sizes of frames found by @ref scan_.
+  std::vector<std::uint64_t> frames_;
+};
+
+}  // namespace palimpsest
@@ -0,0 +1,332 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "palimpsest/Dictionary.h"
+#include "palimpsest/LogIndex.h"
+#include "palimpsest/exceptions/SystemError.h"
+
+namespace palimpsest {
+
+/*! Log dictionaries to a file from a background thread.
+ *
+ * Writing to a file from a control loop puts disk latency in the loop. A
+ * logger instead serializes each frame into a preallocated slot of a ring
+ * buffer, and a background thread writes frames to the file:
+ *
+ * @code{cpp}
+ * Logger logger("upkie.mpack");
+ * while (running) {
+ *   // ... update the observation dictionary
+ *   logger.write(observation);
+ * }
+ * @endcode
+ *
+ * The file is the concatenation of the MessagePack serializations of the
+ * frames, like successive calls to @ref Dictionary::write would produce.
+ * With a non-zero index interval, the logger also writes the index blocks
+ * and footer of an indexed log (see @ref LogIndex), so that @ref LogReader
+ * can seek to any frame without parsing the ones before it. With delta
+ * encoding, most frames only hold the values that changed since the previous
+ * frame, and a keyframe holding every value is written periodically.
+ *
+ * The ring has a single producer, the thread calling @ref write, and a single
+ * consumer, the background thread. Writing a frame neither locks a mutex nor
+ * allocates once the serialization plan of the dictionary is compiled. The
+ * background thread wakes up when a quarter of the ring is filled, or
+ * periodically otherwise, and writes all pending frames with one system call.
+ * When the ring is full, new frames are dropped and counted rather than
+ * blocking the producer.
+ */
+class Logger {
+ public:
+  //! When the background thread asks the kernel to commit the file to disk.
+  enum class SyncPolicy {
+    //! Never, leaving write-back to the operating system.
+    kNone,
+
+    //! At most once per sync period, and when the logger is destroyed.
+    kPeriodic,
+
+    //! After every batch of frames written to the file.
+    kEveryBatch
+  };
+
+  //! Maximum time frames wait in the ring before the thread writes them.
+  static constexpr std::chrono::milliseconds kWritePeriod{10};
+
+  /*! Open a log file and start the background thread.
+   *
+   * @param[in] path Path to the log file, truncated if it exists.
+   * @param[in] frame_capacity Maximum size in bytes of a serialized frame.
+   * @param[in] nb_slots Number of frames the ring buffer can hold.
+   * @param[in] sync_policy When to commit the file to disk.
+   * @param[in] sync_period Minimum duration between two commits with
+   *     @ref SyncPolicy::kPeriodic.
+   * @param[in] index_interval Minimum number of frames between two index
+   *     blocks, or zero to write a plain log without index.
+   *
+   * @throw SystemError if the file cannot be opened.
+   */
+  explicit Logger(
+      const std::string &path, size_t frame_capacity = 64 * 1024,
+      size_t nb_slots = 64, SyncPolicy sync_policy = SyncPolicy::kNone,
+      std::chrono::milliseconds sync_period = std::chrono::seconds(1),
+      size_t index_interval = 0);
+
+  //! Write pending frames, stop the background thread and close the file.
+  ~Logger();
+
+  //! Loggers own a thread and a file, they cannot be copied.
+  Logger(const Logger &) = delete;
+
+  //! Loggers own a thread and a file, they cannot be copied.
+  Logger &operator=(const Logger &) = delete;
+
+  /*! Serialize a dictionary to the next slot of the ring.
+   *
+   * @param[in] dict Dictionary to log.
+   * @return False if the frame was dropped, either because the ring is full
+   *     or because the frame does not fit in a slot.
+   *
+   * @throw PalimpsestError if MPack flags an error while serializing the
+   *     frame, see @ref Dictionary::serialize(char *, size_t) const.
+   *
+   * @note This function is meant to be called from a single thread.
+   */
+  bool write(const Dictionary &dict);
+
+  /*! Copy serialized bytes to the next slot of the ring.
+   *
+   * @param[in] data MessagePack data to log.
+   * @param[in] size Number of bytes.
+   * @return False if the frame was dropped, either because the ring is full
+   *     or because the frame does not fit in a slot.
+   *
+   * @note This function is meant to be called from a single thread.
+   */
+  bool write(const char *data, size_t size);
+
+  /*! Write delta frames between periodic keyframes.
+   *
+   * @param[in] keyframe_interval Maximum number of frames from a keyframe to
+   *     the next, or zero to write every frame as a keyframe.
+   * @param[in] keyframe_period Maximum duration from a keyframe to the next.
+   *
+   * Delta frames only hold the values whose serialized bytes changed since
+   * the previous frame (see @ref Dictionary::serialize_delta), which makes
+   * logs of slowly changing dictionaries several times smaller. Readers
+   * reconstruct a frame by replaying the frames since the last keyframe (see
+   * @ref LogReader::replay), so that the interval and period also bound the
+   * cost of seeking to a frame.
+   *
+   * Deltas are computed from the last frame published to the ring, so that
+   * frames dropped because the ring is full are simply missing from the log.
+   * Structural changes to the dictionary, frames that do not fit in a slot
+   * and frames written from raw bytes make the next frame a keyframe. When
+   * the background thread fails to write frames to the file, it also drops
+   * the deltas that follow them, until the producer writes a keyframe.
+   *
+   * @note This function is meant to be called from the thread calling
+   * @ref write.
+   */
+  void set_delta_encoding(
+      size_t keyframe_interval,
+      std::chrono::milliseconds keyframe_period = std::chrono::seconds(1)) {
+    keyframe_interval_ = keyframe_interval;
+    keyframe_period_ = keyframe_period;
+    baseline_.reset();
+  }
+
+  //! Number of frames dropped so far, including those that failed to write.
+  std::uint64_t dropped_frames() const noexcept {
+    return dropped_frames_.load(std::memory_order_relaxed);
+  }
+
+  //! Number of frames written to the file so far.
+  std::uint64_t written_frames() const noexcept {
+    return written_frames_.load(std::memory_order_relaxed);
+  }
+
+  //! Number of frames in the ring waiting to be written.
+  size_t queue_depth() const noexcept {
+    return head_.load(std::memory_order_relaxed) -
+           tail_.load(std::memory_order_relaxed);
+  }
+
+  //! Largest number of frames that have waited in the ring at once.
+  size_t max_queue_depth() const noexcept {
+    return max_queue_depth_.load(std::memory_order_relaxed);
+  }
+
+  //! Maximum size in bytes of a serialized frame.
+  size_t frame_capacity() const noexcept { return frame_capacity_; }
+
+  //! Number of frames the ring buffer can hold.
+  size_t nb_slots() const noexcept { return nb_slots_; }
+
+ private:
+  /*! Beginning of the slot of a frame.
+   *
+   * @param[in] frame Frame number.
+   */
+  char *slot_data_(std::uint64_t frame) const noexcept {
+    return slots_.get() + (frame % nb_slots_) * slot_stride_;
+  }
+
+  /*! Publish the frame being written to the background thread.
+   *
+   * @param[in] head Number of the frame.
+   * @param[in] marker_size Size of the delta marker at the beginning of the
+   *     slot, zero for a keyframe.
+   * @param[in] size Size of the slot contents in bytes, marker included.
+   * @param[in] depth Number of frames in the ring before this one.
+   */
+  void publish_(std::uint64_t head, size_t marker_size, size_t size,
+                size_t depth);
+
+  //! Main loop of the background thread.
+  void run_();
+
+  /*! Write frames from the ring to the file.
+   *
+   * @param[in] tail Number of the first frame to write.
+   * @param[in] head Number of the frame after the last one to write.
+   * @return Number of frames consumed from the ring.
+   */
+  size_t write_batch_(std::uint64_t tail, std::uint64_t head);
+
+  /*! Write bytes that are not frames, such as index blocks, to the file.
+   *
+   * @param[in] data Bytes to write.
+   * @param[in] size Number of bytes.
+   */
+  void write_all_(const char *data, size_t size);
+
+  /*! Remove bytes written to the file after a given offset.
+   *
+   * @param[in] offset Offset to truncate the file at, and to write from next.
+   *
+   * If the file cannot be truncated, the logger stops writing to it and
+   * drops all further frames, as sequential readers could not find the
+   * frames after the partial write.
+   */
+  void truncate_(std::uint64_t offset);
+
+  /*! Commit the file to disk.
+   *
+   * @param[in] now Current time.
+   */
+  void sync_(std::chrono::steady_clock::time_point now);
+
+ private:
+  //! File descriptor of the log file.
+  int fd_ = -1;
+
+  //! Path to the log file.
+  std::string path_;
+
+  //! Maximum size in bytes of a serialized frame.
+  size_t frame_capacity_;
+
+  //! Number of frames the ring buffer can hold.
+  size_t nb_slots_;
+
+  //! Number of bytes between the beginnings of two slots.
+  size_t slot_stride_;
+
+  //! Queue depth at which the producer wakes up the background thread.
+  size_t batch_size_;
+
+  //! When the background thread commits the file to disk.
+  SyncPolicy sync_policy_;
+
+  //! Minimum duration between two commits with SyncPolicy::kPeriodic.
+  std::chrono::milliseconds sync_period_;
+
+  //! Time of the last commit to disk.
+  std::chrono::steady_clock::time_point last_sync_;
+
+  //! Index of the frames written so far, nullptr for a plain log.
+  std::unique_ptr<LogIndex> index_;
+
+  //! Buffer index blocks are encoded to.
+  std::vector<char> index_bytes_;
+
+  //! Number of bytes written to the file so far.
+  std::uint64_t file_offset_ = 0;
+
+  //! Whether a partial write could not be removed from the file.
+  bool write_failed_ = false;
+
+  //! Memory of the slots, allocated and zero-filled on construction.
+  std::unique_ptr<char[]> slots_;
+
+  //! Size of the contents of each slot, delta marker included.
+  std::vector<size_t> sizes_;
+
+  //! Size of the delta marker at the beginning of each slot.
+  std::vector<size_t> marker_sizes_;
+
+  //! Maximum number of frames from a keyframe to the next, zero for none.
+  size_t keyframe_interval_ = 0;
+
+  //! Maximum duration from a keyframe to the next.
+  std::chrono::milliseconds keyframe_period_{0};
+
+  //! Time of the last keyframe.
+  std::chrono::steady_clock::time_point last_keyframe_;
+
+  //! Number of frames since the last keyframe, including it.
+  size_t nb_frames_since_keyframe_ = 0;
+
+  //! Serialized values of the last frame, for delta encoding.
+  Dictionary::DeltaBaseline baseline_;
+
+  //! Whether the producer should write a keyframe after a failed write.
+  std::atomic<bool> force_keyframe_ = false;
+
+  //! Whether the background thread drops delta frames until a keyframe.
+  bool skip_deltas_ = false;
+
+  //! Number of frames published by the producer.
+  alignas(64) std::atomic<std::uint64_t> head_ = 0;
+
+  //! Number of frames consumed by the background thread.
+  alignas(64) std::atomic<std::uint64_t> tail_ = 0;
+
+  //! Number of frames dropped so far.
+  std::atomic<std::uint64_t> dropped_frames_ = 0;
+
+  //! Number of frames written to the file so far.
+  std::atomic<std::uint64_t> written_frames_ = 0;
+
+  //! Largest number of frames that have waited in the ring at once.
+  std::atomic<size_t> max_queue_depth_ = 0;
+
+  //! Whether the background thread should write pending frames and stop.
+  bool stop_ = false;
+
+  //! Mutex of the condition variable, never locked by the producer.
+  std::mutex mutex_;
+
+  //! Condition variable the background thread waits on.
+  std::condition_variable wake_;
+
+  //! Background thread writing frames to the file.
+  std::thread thread_;
+};
+
+}  // namespace palimpsest
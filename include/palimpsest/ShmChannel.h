@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "palimpsest/Dictionary.h"
+#include "palimpsest/exceptions/SystemError.h"
+
+namespace palimpsest {
+
+/*! Channel publishing serialized dictionaries through POSIX shared memory.
+ *
+ * One process creates the channel and writes frames to it, while other
+ * processes open it and read the latest frame, without locking a mutex:
+ *
+ * @code{cpp}
+ * // Spine process
+ * ShmChannel channel("/upkie_observation", 64 * 1024);
+ * channel.write(observation);
+ *
+ * // Agent process
+ * ShmChannel channel("/upkie_observation");
+ * channel.update(observation);
+ * @endcode
+ *
+ * The shared memory holds two slots, each guarded by a sequence lock. The
+ * writer serializes each frame directly into the slot that does not hold the
+ * latest frame, then publishes it. Readers copy the latest slot and check
+ * that its sequence number did not change meanwhile, otherwise they copy it
+ * again. As the writer alternates between slots, readers only retry when the
+ * writer publishes two frames while they copy one, so that they always get a
+ * complete latest frame while the writer never waits.
+ *
+ * A channel supports one writer at a time. Frames are only kept until the
+ * writer publishes newer ones: readers that fall behind skip frames.
+ */
+class ShmChannel {
+ public:
+  //! Magic number at the beginning of the shared memory.
+  static constexpr std::uint64_t kMagic = 0x6c6e6863706d6970;  // "pimpchnl"
+
+  //! Version of the shared-memory layout.
+  static constexpr std::uint32_t kVersion = 1;
+
+  //! Maximum number of attempts of @ref read to copy the latest frame.
+  static constexpr unsigned kMaxReadAttempts = 1000;
+
+  /*! Create a channel as its writer.
+   *
+   * @param[in] name Name of the shared-memory object, starting with a slash,
+   *     for instance "/upkie_observation".
+   * @param[in] capacity Maximum size in bytes of a frame.
+   *
+   * @throw SystemError if the shared memory cannot be created or mapped.
+   *
+   * An existing shared-memory object of the same name is reset. The object
+   * is unlinked when the writer is destroyed, while readers that have opened
+   * it keep their mapping.
+   */
+  ShmChannel(const std::string &name, size_t capacity);
+
+  /*! Open an existing channel as a reader.
+   *
+   * @param[in] name Name of the shared-memory object created by the writer.
+   *
+   * @throw SystemError if the shared memory cannot be opened or mapped, or
+   *     if it does not hold a channel.
+   */
+  explicit ShmChannel(const std::string &name);
+
+  //! Unmap the shared memory, and unlink it if we created it.
+  ~ShmChannel();
+
+  //! Channels own their mapping, they cannot be copied.
+  ShmChannel(const ShmChannel &) = delete;
+
+  //! Channels own their mapping, they cannot be copied.
+  ShmChannel &operator=(const ShmChannel &) = delete;
+
+  /*! Serialize a dictionary to the channel and publish it as the next frame.
+   *
+   * @param[in] dict Dictionary to serialize.
+   * @return Size of the frame, or the capacity it needs if it does not fit,
+   *     in which case nothing is published.
+   *
+   * @throw SystemError if the channel was opened as a reader.
+   *
+   * The dictionary is serialized directly into shared memory, which does not
+   * allocate once its serialization plan is compiled.
+   */
+  Dictionary::SerializeResult write(const Dictionary &dict);
+
+  /*! Publish serialized bytes as the next frame.
+   *
+   * @param[in] data MessagePack data to publish.
+   * @param[in] size Number of bytes.
+   * @return False if the frame does not fit the channel capacity, in which
+   *     case nothing is published.
+   *
+   * @throw SystemError if the channel was opened as a reader.
+   */
+  bool write(const char *data, size_t size);
+
+  /*! Copy the latest frame if it has not been read yet.
+   *
+   * @param[out] data Memory to copy the frame to, of at least
+   *     @ref capacity bytes.
+   * @return Size of the frame, or zero if no frame has been published since
+   *     the last one this channel read, or if the frame could not be copied
+   *     in @ref kMaxReadAttempts attempts.
+   *
+   * @throw PalimpsestError if the slot of the latest frame holds a size
+   *     beyond the channel capacity, which means the shared memory is
+   *     corrupted.
+   *
+   * A reader retries while the writer updates the slot it copies, yielding
+   * the processor when the slot is being written. Retries are bounded, so
+   * that a writer preempted or stopped in the middle of a frame does not
+   * block readers: the frame is then read by a later call, once published.
+   */
+  size_t read(char *data);
+
+  /*! Update a dictionary from the latest frame if it has not been read yet.
+   *
+   * @param[in, out] dict Dictionary to update.
+   * @return True if the dictionary was updated.
+   *
+   * @throw PalimpsestError if the shared memory is corrupted, see @ref read.
+   * @throw TypeError if deserialized data types don't match those of the
+   *     dictionary.
+   *
+   * The frame is copied to a buffer allocated when the channel was opened,
+   * then read with @ref Dictionary::stream_update.
+   */
+  bool update(Dictionary &dict);
+
+  //! Number of frames published since the channel was created.
+  std::uint64_t frame() const noexcept;
+
+  //! Number of the last frame read by this channel, zero if none.
+  std::uint64_t last_read_frame() const noexcept { return last_read_frame_; }
+
+  //! Maximum size in bytes of a frame.
+  size_t capacity() const noexcept { return capacity_; }
+
+  //! Name of the shared-memory object.
+  const std::string &name() const noexcept { return name_; }
+
+  //! Whether this channel created the shared memory and writes to it.
+  bool is_writer() const noexcept { return is_writer_; }
+
+ private:
+  //! Header at the beginning of the shared memory.
+  struct Header {
+    //! Magic number, written last when the writer creates the channel.
+    std::atomic<std::uint64_t> magic;
+
+    //! Version of the shared-memory layout.
+    std::uint32_t version;
+
+    //! Maximum size in bytes of a frame.
+    std::uint64_t capacity;
+
+    //! Number of the latest published frame, zero if none.
+    alignas(64) std::atomic<std::uint64_t> frame;
+  };
+
+  //! Header of each of the two frame slots.
+  struct alignas(64) Slot {
+    //! Sequence number, odd while the writer updates the slot.
+    std::atomic<std::uint64_t> sequence;
+
+    //! Number of the frame in the slot.
+    std::atomic<std::uint64_t> frame;
+
+    //! Size of the frame in bytes.
+    std::atomic<std::uint64_t> size;
+  };
+
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                "Shared-memory atomics need to be lock-free");
+
+  /*! Number of bytes between the beginnings of the two slots.
+   *
+   * @param[in] capacity Maximum size in bytes of a frame.
+   */
+  static size_t slot_stride_(size_t capacity) noexcept;
+
+  /*! Number of bytes of the shared memory of a channel.
+   *
+   * @param[in] capacity Maximum size in bytes of a frame.
+   */
+  static size_t mapped_size_(size_t capacity) noexcept;
+
+  /*! Slot of a frame.
+   *
+   * @param[in] frame Frame number.
+   */
+  Slot &slot_(std::uint64_t frame) const noexcept;
+
+  /*! Frame data in a slot.
+   *
+   * @param[in] slot Slot holding the frame.
+   */
+  char *slot_data_(Slot &slot) const noexcept;
+
+  //! Check that the channel was created by this process.
+  void check_writer_() const;
+
+  /*! Start writing the next frame.
+   *
+   * @return Slot to write the frame to.
+   */
+  Slot &begin_write_() noexcept;
+
+  /*! Publish the frame being written.
+   *
+   * @param[in, out] slot Slot returned by @ref begin_write_.
+   * @param[in] size Size of the frame in bytes.
+   */
+  void end_write_(Slot &slot, size_t size) noexcept;
+
+  /*! Release the slot of a frame that could not be written.
+   *
+   * @param[in, out] slot Slot returned by @ref begin_write_.
+   */
+  void abort_write_(Slot &slot) noexcept;
+
+  /*! Map the shared memory.
+   *
+   * @param[in] fd File descriptor of the shared-memory object.
+   * @param[in] size Number of bytes to map.
+   * @param[in] writable Whether to map the memory for writing as well.
+   */
+  void map_(int fd, size_t size, bool writable);
+
+ private:
+  //! Name of the shared-memory object.
+  std::string name_;
+
+  //! Maximum size in bytes of a frame.
+  size_t capacity_ = 0;
+
+  //! Whether this channel created the shared memory and writes to it.
+  bool is_writer_ = false;
+
+  //! Beginning of the mapped shared memory.
+  void *mapping_ = nullptr;
+
+  //! Number of mapped bytes.
+  size_t mapped_bytes_ = 0;
+
+  //! Header of the shared memory.
+  Header *header_ = nullptr;
+
+  //! Number of the last frame read by this channel.
+  std::uint64_t last_read_frame_ = 0;
+
+  //! Buffer frames are copied to by @ref update.
+  std::vector<char> buffer_;
+};
+
+}  // namespace palimpsest
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <string>
+
+#include "palimpsest/exceptions/PalimpsestError.h"
+
+namespace palimpsest::exceptions {
+
+//! Structural modification of a frozen dictionary.
+class FrozenError : public PalimpsestError {
+ public:
+  /*! Create a frozen-dictionary error.
+   *
+   * @param[in] file Source file of the instruction that threw the error.
+   * @param[in] line Line of code in that file where the throw originates from.
+   * @param[in] message Error message.
+   */
+  FrozenError(const std::string& file, unsigned line,
+              const std::string& message)
+      : PalimpsestError(file, line, message) {}
+
+  //! Empty destructor
+  ~FrozenError() throw() {}
+};
+
+}  // namespace palimpsest::exceptions
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <cstring>
+#include <string>
+
+#include "palimpsest/exceptions/PalimpsestError.h"
+
+namespace palimpsest::exceptions {
+
+//! Failed system call, such as opening or mapping a file.
+class SystemError : public PalimpsestError {
+ public:
+  /*! Create a system error.
+   *
+   * @param[in] file Source file of the instruction that threw the error.
+   * @param[in] line Line of code in that file where the throw originates from.
+   * @param[in] message Error message.
+   * @param[in] error_number Value of errno after the failed call, or zero if
+   *     the failure does not come with one.
+   */
+  SystemError(const std::string& file, unsigned line,
+              const std::string& message, int error_number = 0)
+      : PalimpsestError(file, line,
+                        error_number != 0
+                            ? message + ": " + std::strerror(error_number)
+                            : message),
+        error_number_(error_number) {}
+
+  //! Empty destructor
+  ~SystemError() throw() {}
+
+  //! Value of errno after the failed call, zero if there was none.
+  int error_number() const noexcept { return error_number_; }
+
+ private:
+  //! Value of errno after the failed call.
+  int error_number_;
+};
+
+}  // namespace palimpsest::exceptions
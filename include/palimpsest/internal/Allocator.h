@@ -11,7 +11,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <memory>
+#include <type_traits>
 
 namespace palimpsest::internal {
 
@@ -25,4 +28,20 @@ template <typename T>
 struct Allocator<T, typename T::eigen_aligned_operator_new_marker_type>
     : public Eigen::aligned_allocator<T> {};
 
+/*! Alignment in bytes of buffers holding an object of type T.
+ *
+ * This is alignof(T) for usual types.
+ */
+template <typename T, typename = void>
+struct alignment : public std::integral_constant<std::size_t, alignof(T)> {};
+
+/*! Alignment of EIGEN_MAKE_ALIGNED_OPERATOR_NEW types is at least that of
+ * Eigen::aligned_allocator.
+ */
+template <typename T>
+struct alignment<T, typename T::eigen_aligned_operator_new_marker_type>
+    : public std::integral_constant<
+          std::size_t, std::max<std::size_t>(alignof(T),
+                                             EIGEN_MAX_ALIGN_BYTES)> {};
+
 }  // namespace palimpsest::internal
@@ -0,0 +1,692 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "palimpsest/internal/hash.h"
+
+namespace palimpsest::internal {
+
+/*! Growable array of trivially copyable items allocated from a memory
+ * resource.
+ *
+ * Contrary to std::pmr::vector, moving an array always transfers its storage,
+ * even between different memory resources, since each array remembers the
+ * resource it was allocated from.
+ */
+template <typename T>
+class RawArray {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "RawArray only holds trivially copyable items");
+
+ public:
+  /*! Create an empty array.
+   *
+   * @param[in] resource Memory resource to allocate items from.
+   */
+  explicit RawArray(std::pmr::memory_resource *resource) noexcept
+      : resource_(resource) {}
+
+  //! No copy constructor.
+  RawArray(const RawArray &) = delete;
+
+  //! No copy assignment operator.
+  RawArray &operator=(const RawArray &) = delete;
+
+  //! Move constructor.
+  RawArray(RawArray &&other) noexcept
+      : resource_(other.resource_),
+        data_(other.data_),
+        size_(other.size_),
+        capacity_(other.capacity_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+  }
+
+  //! Move assignment operator.
+  RawArray &operator=(RawArray &&other) noexcept {
+    if (this != &other) {
+      release();
+      resource_ = other.resource_;
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = nullptr;
+      other.size_ = 0;
+      other.capacity_ = 0;
+    }
+    return *this;
+  }
+
+  //! Free the internal buffer.
+  ~RawArray() { release(); }
+
+  //! Pointer to the first item.
+  T *data() noexcept { return data_; }
+
+  //! Pointer to the first item.
+  const T *data() const noexcept { return data_; }
+
+  //! Number of items in the array.
+  size_t size() const noexcept { return size_; }
+
+  //! Number of items the array can hold without reallocating.
+  size_t capacity() const noexcept { return capacity_; }
+
+  //! Item at a given index.
+  T &operator[](size_t i) noexcept { return data_[i]; }
+
+  //! Item at a given index.
+  const T &operator[](size_t i) const noexcept { return data_[i]; }
+
+  //! Last item of the array.
+  T &back() noexcept { return data_[size_ - 1]; }
+
+  //! Append an item, growing the array if needed.
+  void push_back(const T &item) {
+    if (size_ == capacity_) {
+      reserve(capacity_ < 4 ? 4 : 2 * capacity_);
+    }
+    data_[size_++] = item;
+  }
+
+  /*! Append a range of items, growing the array if needed.
+   *
+   * @param[in] items Pointer to the first item to append.
+   * @param[in] count Number of items to append.
+   */
+  void append(const T *items, size_t count) {
+    if (size_ + count > capacity_) {
+      size_t new_capacity = (capacity_ < 4) ? 4 : capacity_;
+      while (new_capacity < size_ + count) {
+        new_capacity *= 2;
+      }
+      reserve(new_capacity);
+    }
+    if (count > 0) {
+      std::memcpy(data_ + size_, items, count * sizeof(T));
+    }
+    size_ += count;
+  }
+
+  //! Remove the last item.
+  void pop_back() noexcept { --size_; }
+
+  /*! Resize the array, leaving new items uninitialized.
+   *
+   * @param[in] size New number of items.
+   */
+  void resize(size_t size) {
+    reserve(size);
+    size_ = size;
+  }
+
+  //! Remove all items, keeping the allocated capacity.
+  void clear() noexcept { size_ = 0; }
+
+  /*! Make sure the array can hold a given number of items.
+   *
+   * @param[in] capacity Minimum capacity.
+   */
+  void reserve(size_t capacity) {
+    if (capacity <= capacity_) {
+      return;
+    }
+    T *new_data = static_cast<T *>(
+        resource_->allocate(capacity * sizeof(T), alignof(T)));
+    if (size_ > 0) {
+      std::memcpy(new_data, data_, size_ * sizeof(T));
+    }
+    if (data_ != nullptr) {
+      resource_->deallocate(data_, capacity_ * sizeof(T), alignof(T));
+    }
+    data_ = new_data;
+    capacity_ = capacity;
+  }
+
+  //! Free the internal buffer, leaving an empty array.
+  void release() noexcept {
+    if (data_ != nullptr) {
+      resource_->deallocate(data_, capacity_ * sizeof(T), alignof(T));
+    }
+    data_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
+  }
+
+ private:
+  //! Memory resource the buffer is allocated from.
+  std::pmr::memory_resource *resource_;
+
+  //! Internal buffer.
+  T *data_ = nullptr;
+
+  //! Number of items in the array.
+  size_t size_ = 0;
+
+  //! Number of items allocated in the internal buffer.
+  size_t capacity_ = 0;
+};
+
+/*! Flat hash map from string keys to values with stable addresses.
+ *
+ * Entries are stored contiguously in insertion order, with their key
+ * characters packed in a single character pool. Maps with few keys are
+ * searched by a linear scan over precomputed hashes, while larger maps add an
+ * open-addressing index (linear probing) over entries. Values themselves live
+ * in slabs of contiguous storage, so that references to them stay valid until
+ * they are erased.
+ *
+ * All internal buffers are allocated from a single memory resource.
+ */
+template <typename T>
+class FlatMap {
+ public:
+  //! Maps with at most this number of keys are searched linearly.
+  static constexpr size_t kMaxLinearSize = 8;
+
+  //! Entry of the map.
+  struct Entry {
+    //! Hash of the key.
+    std::uint64_t hash;
+
+    //! Offset of the key in the character pool.
+    std::uint32_t key_offset;
+
+    //! Length of the key.
+    std::uint32_t key_size;
+
+    //! Pointer to the value.
+    T *value;
+  };
+
+  //! Iterator over key-value pairs, in insertion order.
+  template <typename ValueT>
+  class Iterator {
+   public:
+    //! Key-value pair.
+    using Pair = std::pair<std::string_view, ValueT &>;
+
+    /*! Create iterator.
+     *
+     * @param[in] entry Pointer to the current entry.
+     * @param[in] keys Pointer to the character pool.
+     */
+    Iterator(const Entry *entry, const char *keys) noexcept
+        : entry_(entry), keys_(keys) {}
+
+    //! Get current key-value pair.
+    Pair operator*() const noexcept {
+      return Pair(std::string_view(keys_ + entry_->key_offset,
+                                   entry_->key_size),
+                  *entry_->value);
+    }
+
+    //! Advance to the next entry.
+    Iterator &operator++() noexcept {
+      ++entry_;
+      return *this;
+    }
+
+    //! Check whether two iterators point to different entries.
+    bool operator!=(const Iterator &other) const noexcept {
+      return entry_ != other.entry_;
+    }
+
+   private:
+    //! Current entry.
+    const Entry *entry_;
+
+    //! Character pool.
+    const char *keys_;
+  };
+
+  /*! Create an empty map.
+   *
+   * @param[in] resource Memory resource to allocate buffers from, or nullptr
+   *     to use the default memory resource.
+   */
+  explicit FlatMap(std::pmr::memory_resource *resource = nullptr) noexcept
+      : resource_(resource ? resource : std::pmr::get_default_resource()),
+        entries_(resource_),
+        index_(resource_),
+        keys_(resource_),
+        slabs_(resource_),
+        free_slots_(resource_) {}
+
+  //! No copy constructor.
+  FlatMap(const FlatMap &) = delete;
+
+  //! No copy assignment operator.
+  FlatMap &operator=(const FlatMap &) = delete;
+
+  //! Move constructor.
+  FlatMap(FlatMap &&other) noexcept
+      : resource_(other.resource_),
+        entries_(std::move(other.entries_)),
+        index_(std::move(other.index_)),
+        keys_(std::move(other.keys_)),
+        slabs_(std::move(other.slabs_)),
+        current_slab_(other.current_slab_),
+        free_slots_(std::move(other.free_slots_)),
+        dead_key_chars_(other.dead_key_chars_) {
+    other.current_slab_ = 0;
+    other.dead_key_chars_ = 0;
+  }
+
+  //! Move assignment operator.
+  FlatMap &operator=(FlatMap &&other) noexcept {
+    if (this != &other) {
+      destroy_values_();
+      release_slabs_();
+      resource_ = other.resource_;
+      entries_ = std::move(other.entries_);
+      index_ = std::move(other.index_);
+      keys_ = std::move(other.keys_);
+      slabs_ = std::move(other.slabs_);
+      current_slab_ = other.current_slab_;
+      free_slots_ = std::move(other.free_slots_);
+      dead_key_chars_ = other.dead_key_chars_;
+      other.current_slab_ = 0;
+      other.dead_key_chars_ = 0;
+    }
+    return *this;
+  }
+
+  //! Destroy all values and free internal buffers.
+  ~FlatMap() {
+    destroy_values_();
+    release_slabs_();
+  }
+
+  //! Memory resource internal buffers are allocated from.
+  std::pmr::memory_resource *resource() const noexcept { return resource_; }
+
+  //! Number of entries in the map.
+  size_t size() const noexcept { return entries_.size(); }
+
+  //! Check whether the map is empty.
+  bool empty() const noexcept { return entries_.size() == 0; }
+
+  //! Iterator to the first entry.
+  Iterator<T> begin() noexcept {
+    return Iterator<T>(entries_.data(), keys_.data());
+  }
+
+  //! Iterator past the last entry.
+  Iterator<T> end() noexcept {
+    return Iterator<T>(entries_.data() + entries_.size(), keys_.data());
+  }
+
+  //! Iterator to the first entry.
+  Iterator<const T> begin() const noexcept {
+    return Iterator<const T>(entries_.data(), keys_.data());
+  }
+
+  //! Iterator past the last entry.
+  Iterator<const T> end() const noexcept {
+    return Iterator<const T>(entries_.data() + entries_.size(), keys_.data());
+  }
+
+  /*! Hash a key.
+   *
+   * @param[in] key Key to hash.
+   * @return Hash of the key.
+   */
+  static constexpr std::uint64_t hash(std::string_view key) noexcept {
+    return fnv1a(key);
+  }
+
+  /*! Find the value at a given key.
+   *
+   * @param[in] key Key to look for.
+   * @return Pointer to the value if the key is in the map, nullptr otherwise.
+   */
+  T *find(std::string_view key) const noexcept {
+    return find(key, hash(key));
+  }
+
+  /*! Find the value at a given key whose hash is already known.
+   *
+   * @param[in] key Key to look for.
+   * @param[in] key_hash Hash of the key, as computed by @ref hash.
+   * @return Pointer to the value if the key is in the map, nullptr otherwise.
+   */
+  T *find(std::string_view key, std::uint64_t key_hash) const noexcept {
+    const size_t i = find_entry_(key, key_hash);
+    return (i < entries_.size()) ? entries_[i].value : nullptr;
+  }
+
+  /*! Get the value at a given key, constructing it if it does not exist yet.
+   *
+   * @param[in] key Key to look for.
+   * @param args Arguments forwarded to the value constructor, if any.
+   * @return Pair of a reference to the value and a boolean set to true if
+   *     and only if the value was constructed.
+   */
+  template <typename... Args>
+  std::pair<T &, bool> try_emplace(std::string_view key, Args &&...args) {
+    return try_emplace_hashed(key, hash(key), std::forward<Args>(args)...);
+  }
+
+  /*! Variant of @ref try_emplace for keys whose hash is already known.
+   *
+   * @param[in] key Key to look for.
+   * @param[in] key_hash Hash of the key, as computed by @ref hash.
+   * @param args Arguments forwarded to the value constructor, if any.
+   * @return Pair of a reference to the value and a boolean set to true if
+   *     and only if the value was constructed.
+   */
+  template <typename... Args>
+  std::pair<T &, bool> try_emplace_hashed(std::string_view key,
+                                          std::uint64_t key_hash,
+                                          Args &&...args) {
+    const size_t i = find_entry_(key, key_hash);
+    if (i < entries_.size()) {
+      return {*entries_[i].value, false};
+    }
+    T *slot = allocate_slot_();
+    new (slot) T(std::forward<Args>(args)...);
+    Entry entry;
+    entry.hash = key_hash;
+    entry.key_offset = static_cast<std::uint32_t>(keys_.size());
+    entry.key_size = static_cast<std::uint32_t>(key.size());
+    entry.value = slot;
+    keys_.append(key.data(), key.size());
+    entries_.push_back(entry);
+    if (index_.size() > 0 || entries_.size() > kMaxLinearSize) {
+      if (2 * entries_.size() > index_.size()) {
+        rebuild_index_();
+      } else {
+        insert_in_index_(entries_.size() - 1);
+      }
+    }
+    return {*slot, true};
+  }
+
+  /*! Erase the entry at a given key.
+   *
+   * @param[in] key Key to erase.
+   * @return true if the key was found and erased, false otherwise.
+   *
+   * @note The last entry is moved in place of the erased one, so that entries
+   *     stay contiguous.
+   */
+  bool erase(std::string_view key) {
+    const size_t i = find_entry_(key, hash(key));
+    if (i >= entries_.size()) {
+      return false;
+    }
+    T *value = entries_[i].value;
+    dead_key_chars_ += entries_[i].key_size;
+    entries_[i] = entries_.back();
+    entries_.pop_back();
+    value->~T();
+    free_slots_.push_back(value);
+    if (2 * dead_key_chars_ > keys_.size()) {
+      compact_keys_();
+    }
+    if (index_.size() > 0) {
+      rebuild_index_();
+    }
+    return true;
+  }
+
+  /*! Allocate buffers for a given number of entries at once.
+   *
+   * @param[in] nb_entries Number of entries to make room for.
+   * @param[in] nb_key_chars Total number of characters of their keys.
+   *
+   * @note This function is meant to be called on an empty map. Inserting up
+   *     to the reserved number of entries then allocates nothing more.
+   */
+  void reserve(size_t nb_entries, size_t nb_key_chars) {
+    entries_.reserve(nb_entries);
+    keys_.reserve(nb_key_chars);
+    if (nb_entries > kMaxLinearSize && index_.size() == 0) {
+      const size_t capacity = index_capacity_(nb_entries);
+      index_.resize(capacity);
+      std::memset(index_.data(), 0, capacity * sizeof(std::uint32_t));
+    }
+    if (nb_entries > 0 && slabs_.size() == 0) {
+      slabs_.reserve(1);
+      Slab slab;
+      slab.capacity = nb_entries;
+      slab.data = static_cast<T *>(
+          resource_->allocate(slab.capacity * sizeof(T), alignof(T)));
+      slab.used = 0;
+      slabs_.push_back(slab);
+    }
+  }
+
+  /*! Upper bound on the memory allocated by @ref reserve.
+   *
+   * @param[in] nb_entries Number of entries.
+   * @param[in] nb_key_chars Total number of characters of their keys.
+   * @return Number of bytes, including alignment padding.
+   */
+  static size_t reserved_bytes(size_t nb_entries, size_t nb_key_chars) {
+    if (nb_entries == 0) {
+      return 0;
+    }
+    size_t bytes = nb_entries * sizeof(Entry) + alignof(Entry);
+    bytes += nb_key_chars;
+    if (nb_entries > kMaxLinearSize) {
+      bytes += index_capacity_(nb_entries) * sizeof(std::uint32_t) +
+               alignof(std::uint32_t);
+    }
+    bytes += sizeof(Slab) + alignof(Slab);
+    bytes += nb_entries * sizeof(T) + alignof(T);
+    return bytes;
+  }
+
+  //! Remove all entries, keeping allocated buffers for future insertions.
+  void clear() noexcept {
+    destroy_values_();
+    entries_.clear();
+    index_.clear();
+    keys_.clear();
+    free_slots_.clear();
+    dead_key_chars_ = 0;
+    for (size_t i = 0; i < slabs_.size(); ++i) {
+      slabs_[i].used = 0;
+    }
+    current_slab_ = 0;
+  }
+
+ private:
+  //! Slab of contiguous value storage.
+  struct Slab {
+    //! Storage for values.
+    T *data;
+
+    //! Number of values the slab can hold.
+    size_t capacity;
+
+    //! Number of slots handed out from this slab.
+    size_t used;
+  };
+
+  //! Smallest number of values in a slab.
+  static constexpr size_t kMinSlabCapacity = 4;
+
+  /*! Find the index of the entry at a given key.
+   *
+   * @param[in] key Key to look for.
+   * @param[in] key_hash Hash of the key.
+   * @return Index of the entry if found, entries_.size() otherwise.
+   */
+  size_t find_entry_(std::string_view key,
+                     std::uint64_t key_hash) const noexcept {
+    const size_t nb_entries = entries_.size();
+    if (index_.size() == 0) {
+      for (size_t i = 0; i < nb_entries; ++i) {
+        if (matches_(entries_[i], key, key_hash)) {
+          return i;
+        }
+      }
+      return nb_entries;
+    }
+    const size_t mask = index_.size() - 1;
+    for (size_t pos = key_hash & mask;; pos = (pos + 1) & mask) {
+      const std::uint32_t slot = index_[pos];
+      if (slot == 0) {
+        return nb_entries;
+      } else if (matches_(entries_[slot - 1], key, key_hash)) {
+        return slot - 1;
+      }
+    }
+  }
+
+  /*! Check whether an entry has a given key.
+   *
+   * @param[in] entry Entry to check.
+   * @param[in] key Key to compare with.
+   * @param[in] key_hash Hash of the key.
+   */
+  bool matches_(const Entry &entry, std::string_view key,
+                std::uint64_t key_hash) const noexcept {
+    return entry.hash == key_hash && entry.key_size == key.size() &&
+           std::memcmp(keys_.data() + entry.key_offset, key.data(),
+                       key.size()) == 0;
+  }
+
+  /*! Add an entry to the open-addressing index.
+   *
+   * @param[in] i Index of the entry.
+   */
+  void insert_in_index_(size_t i) noexcept {
+    const size_t mask = index_.size() - 1;
+    size_t pos = entries_[i].hash & mask;
+    while (index_[pos] != 0) {
+      pos = (pos + 1) & mask;
+    }
+    index_[pos] = static_cast<std::uint32_t>(i + 1);
+  }
+
+  //! Rebuild the open-addressing index, or drop it if the map is small.
+  void rebuild_index_() {
+    const size_t nb_entries = entries_.size();
+    if (nb_entries <= kMaxLinearSize) {
+      index_.clear();
+      return;
+    }
+    const size_t capacity = index_capacity_(nb_entries);
+    index_.resize(capacity);
+    std::memset(index_.data(), 0, capacity * sizeof(std::uint32_t));
+    for (size_t i = 0; i < nb_entries; ++i) {
+      insert_in_index_(i);
+    }
+  }
+
+  /*! Capacity of the open-addressing index for a given number of entries.
+   *
+   * @param[in] nb_entries Number of entries in the map.
+   * @return Power of two at least twice the number of entries.
+   */
+  static size_t index_capacity_(size_t nb_entries) noexcept {
+    size_t capacity = 2 * kMaxLinearSize;
+    while (capacity < 2 * nb_entries) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  /*! Remove characters of erased keys from the character pool.
+   *
+   * Keys are copied to a new pool, since erasing moves the last entry in
+   * place of the erased one, so that key offsets are not sorted by entry.
+   */
+  void compact_keys_() {
+    RawArray<char> keys(resource_);
+    keys.reserve(keys_.size() - dead_key_chars_);
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      Entry &entry = entries_[i];
+      const size_t offset = keys.size();
+      keys.append(keys_.data() + entry.key_offset, entry.key_size);
+      entry.key_offset = static_cast<std::uint32_t>(offset);
+    }
+    keys_ = std::move(keys);
+    dead_key_chars_ = 0;
+  }
+
+  //! Get uninitialized storage for a new value.
+  T *allocate_slot_() {
+    if (free_slots_.size() > 0) {
+      T *slot = free_slots_.back();
+      free_slots_.pop_back();
+      return slot;
+    }
+    // Slabs emptied by clear are filled again before allocating a new one
+    while (current_slab_ < slabs_.size() &&
+           slabs_[current_slab_].used == slabs_[current_slab_].capacity) {
+      ++current_slab_;
+    }
+    if (current_slab_ == slabs_.size()) {
+      Slab slab;
+      slab.capacity =
+          (slabs_.size() == 0) ? kMinSlabCapacity : 2 * slabs_.back().capacity;
+      slab.data = static_cast<T *>(
+          resource_->allocate(slab.capacity * sizeof(T), alignof(T)));
+      slab.used = 0;
+      slabs_.push_back(slab);
+    }
+    Slab &slab = slabs_[current_slab_];
+    return slab.data + slab.used++;
+  }
+
+  //! Destroy all values in the map.
+  void destroy_values_() noexcept {
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      entries_[i].value->~T();
+    }
+    entries_.clear();
+  }
+
+  //! Free value storage. Values should be destroyed beforehand.
+  void release_slabs_() noexcept {
+    for (size_t i = 0; i < slabs_.size(); ++i) {
+      resource_->deallocate(slabs_[i].data, slabs_[i].capacity * sizeof(T),
+                            alignof(T));
+    }
+    slabs_.release();
+    current_slab_ = 0;
+    free_slots_.release();
+  }
+
+ private:
+  //! Memory resource internal buffers are allocated from.
+  std::pmr::memory_resource *resource_;
+
+  //! Entries in insertion order.
+  RawArray<Entry> entries_;
+
+  //! Open-addressing index: entry index plus one, or zero for empty slots.
+  RawArray<std::uint32_t> index_;
+
+  //! Character pool holding all keys.
+  RawArray<char> keys_;
+
+  //! Slabs of value storage.
+  RawArray<Slab> slabs_;
+
+  //! Index of the slab new values are allocated from.
+  size_t current_slab_ = 0;
+
+  //! Slots of erased values, available for reuse.
+  RawArray<T *> free_slots_;
+
+  //! Number of characters of erased keys still in the character pool.
+  size_t dead_key_chars_ = 0;
+};
+
+}  // namespace palimpsest::internal
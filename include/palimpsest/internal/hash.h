@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace palimpsest::internal {
+
+//! FNV-1a 64-bit offset basis.
+constexpr std::uint64_t kFnv1aOffsetBasis = 14695981039346656037ull;
+
+//! FNV-1a 64-bit prime.
+constexpr std::uint64_t kFnv1aPrime = 1099511628211ull;
+
+/*! Hash a string with the 64-bit FNV-1a function.
+ *
+ * @param[in] str String to hash.
+ * @return Hash of the string.
+ *
+ * Contrary to std::hash, this function is constexpr and its output does not
+ * depend on the platform or standard library, so that hashes can be computed
+ * at compile time.
+ */
+constexpr std::uint64_t fnv1a(std::string_view str) noexcept {
+  std::uint64_t hash = kFnv1aOffsetBasis;
+  for (const char c : str) {
+    hash ^= static_cast<std::uint8_t>(c);
+    hash *= kFnv1aPrime;
+  }
+  return hash;
+}
+
+}  // namespace palimpsest::internal
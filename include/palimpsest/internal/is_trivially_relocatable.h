@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <type_traits>
+
+namespace palimpsest::internal {
+
+/*! Check whether objects of type T can be moved by copying their bytes.
+ *
+ * This is the case for trivially copyable types, as well as for types that
+ * do not point to their own storage, such as fixed-size Eigen matrices.
+ */
+template <typename T>
+struct is_trivially_relocatable : public std::is_trivially_copyable<T> {};
+
+//! Fixed-size Eigen matrices are trivially relocatable.
+template <typename Scalar, int Rows, int Cols, int Options, int MaxRows,
+          int MaxCols>
+struct is_trivially_relocatable<
+    Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>>
+    : public std::integral_constant<
+          bool, Rows != Eigen::Dynamic && Cols != Eigen::Dynamic &&
+                    is_trivially_relocatable<Scalar>::value> {};
+
+//! Eigen quaternions are trivially relocatable.
+template <typename Scalar, int Options>
+struct is_trivially_relocatable<Eigen::Quaternion<Scalar, Options>>
+    : public is_trivially_relocatable<Scalar> {};
+
+}  // namespace palimpsest::internal
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "palimpsest/internal/hash.h"
+
+namespace palimpsest::internal {
+
+/*! Compute a type tag at compile time.
+ *
+ * @return Hash of the signature of this function, which spells out T.
+ *
+ * Contrary to typeid(T).hash_code(), this function is constexpr, so that
+ * comparing the tag of a stored object with that of a requested type boils
+ * down to comparing two integers.
+ */
+template <typename T>
+constexpr std::uint64_t type_tag() noexcept {
+#if defined(_MSC_VER)
+  return fnv1a(__FUNCSIG__);
+#else
+  return fnv1a(__PRETTY_FUNCTION__);
+#endif
+}
+
+//! Type tag of T without cv-qualifiers, see @ref type_tag.
+template <typename T>
+inline constexpr std::uint64_t type_tag_v = type_tag<std::remove_cv_t<T>>();
+
+}  // namespace palimpsest::internal
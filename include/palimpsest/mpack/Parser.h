@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <mpack.h>
+
+#include <vector>
+
+namespace palimpsest::mpack {
+
+/*! Parse MessagePack (using MPack's Node API) into a reusable node pool.
+ *
+ * Parsing a message with @c mpack_tree_init_data allocates the node pages of
+ * a new tree each time. A parser instead keeps one pool of nodes across
+ * messages, so that parsing messages of a steady size does not allocate.
+ * The pool grows if a message needs more nodes than it holds.
+ *
+ * The parser owns the tree of the last message it parsed: nodes returned by
+ * @ref parse remain valid until the next call to @ref parse or until the
+ * parser is destroyed, including when processing them throws an exception.
+ */
+class Parser {
+ public:
+  //! Default number of nodes in the pool.
+  static constexpr size_t kDefaultNodePoolSize = 1024;
+
+  /*! Constructor.
+   *
+   * @param[in] nb_nodes Initial number of nodes in the pool.
+   */
+  explicit Parser(size_t nb_nodes = kDefaultNodePoolSize);
+
+  //! Destructor.
+  ~Parser();
+
+  //! Parsers own their tree, they cannot be copied.
+  Parser(const Parser &) = delete;
+
+  //! Parsers own their tree, they cannot be copied.
+  Parser &operator=(const Parser &) = delete;
+
+  /*! Parse a message.
+   *
+   * @param[in] data Buffer to read MessagePack from.
+   * @param[in] size Buffer size.
+   * @return Root node of the message, or a nil node if parsing failed. The
+   *     node refers to @p data, which must outlive it.
+   */
+  mpack_node_t parse(const char *data, size_t size);
+
+  //! Error state of the last parsed message, mpack_ok if there is none.
+  mpack_error_t error() noexcept;
+
+  //! Number of nodes in the pool.
+  size_t capacity() const noexcept { return pool_.size(); }
+
+ private:
+  //! Destroy the tree of the last message, if any.
+  void destroy_tree_() noexcept;
+
+ private:
+  //! Node pool of the tree.
+  std::vector<mpack_node_data_t> pool_;
+
+  //! Tree of the last parsed message.
+  mpack_tree_t tree_;
+
+  //! Whether @ref tree_ has been initialized and not destroyed yet.
+  bool has_tree_ = false;
+};
+
+}  // namespace palimpsest::mpack
@@ -21,31 +21,70 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <utility>
 #include <vector>
 
+#include "palimpsest/mpack/binary.h"
+#include "palimpsest/mpack/write_doubles.h"
+
 namespace palimpsest::mpack {
 
 /*! Write MessagePack (using MPack's Write API) to a vector of bytes.
  *
  * Writers assume they are given ownership of the bytes buffer. In particular,
- * they may resize it dynamically as needed.
+ * they may resize it dynamically as needed. Alternatively, writers can write
+ * to caller-provided memory of fixed capacity, which they never grow, or to
+ * a buffer they own.
  *
- * @note After a message has been fully written, the writer instance must be
- * discarded to create a new message.
+ * After a message has been fully written, call @ref reset to write a new
+ * message to the same buffer. Buffers keep the capacity they have grown to,
+ * so that a long-lived writer does not allocate once it has seen its largest
+ * message.
  */
 class Writer {
  public:
+  /*! Constructor for a buffer owned by the writer.
+   *
+   * The buffer grows as needed. Unlike a vector of bytes, memory added to it
+   * is left uninitialized, as it is overwritten by the message anyway.
+   */
+  Writer();
+
   /*! Constructor.
    *
    * @param buffer Buffer used to store the data. It may grow if needed.
    */
   explicit Writer(std::vector<char> &buffer);
 
+  /*! Constructor for a fixed-capacity buffer.
+   *
+   * @param data Memory to write the message to.
+   * @param capacity Number of bytes available at @p data.
+   *
+   * The writer neither allocates nor writes past @p capacity. If the message
+   * does not fit, the bytes that don't fit are counted then discarded, so
+   * that @ref required_size gives the capacity the message needs.
+   */
+  Writer(char *data, size_t capacity);
+
   //! Destructor.
   ~Writer();
 
+  //! Writers refer to their own state, they cannot be copied.
+  Writer(const Writer &) = delete;
+
+  //! Writers refer to their own state, they cannot be copied.
+  Writer &operator=(const Writer &) = delete;
+
+  /*! Start a new message on the same buffer.
+   *
+   * The previous message, finished or not, is discarded. The buffer keeps the
+   * capacity it has grown to.
+   */
+  void reset();
+
   /*! Add data to the MessagePack (basic)
    *
    * These overload set allows to write basic data to the MessagePack
@@ -87,6 +126,9 @@ class Writer {
   //! Write an std::string.
   void write(const std::string &s);
 
+  //! Write an std::string_view.
+  void write(std::string_view s);
+
   /*! Write a C-style string.
    *
    * @param[in] s C-style string.
@@ -97,7 +139,8 @@ class Writer {
    *
    * @param[in] v Two-dimensional vector.
    *
-   * Serializes as an array of size 2.
+   * Serializes as an array of size 2, or as a binary blob depending on
+   * @ref array_encoding (and likewise for other dense Eigen types).
    */
   void write(const Eigen::Vector2d &v);
 
@@ -133,6 +176,25 @@ class Writer {
    */
   void write(const Eigen::Matrix3d &m);
 
+  /*! Write an std::vector<double>.
+   *
+   * @param[in] v Vector of doubles.
+   *
+   * Serializes as an array of doubles, encoded in bulk.
+   */
+  void write(const std::vector<double> &v);
+
+  /*! Write raw bytes that are already MessagePack-encoded.
+   *
+   * @param[in] data Pointer to the encoded bytes.
+   * @param[in] size Number of bytes.
+   *
+   * @note The bytes are copied as is, without checking that they form valid
+   * MessagePack. This function is not compatible with MPACK_WRITE_TRACKING,
+   * which expects raw bytes only inside strings and binary blobs.
+   */
+  void write_bytes(const char *data, size_t size);
+
   /*! Add data to the MessagePack (containers).
    *
    * These functions support the serialization of standard containers of
@@ -220,16 +282,112 @@ class Writer {
    *
    * @return Effective size of MessagePack data. Note that ``buffer.size()`` is
    *     likely different.
+   *
+   * @throw PalimpsestError if MPack flagged an error while writing, for
+   *     instance if the buffer failed to grow, so that callers never take
+   *     the size of an invalid message for zero.
    */
   size_t finish();
 
+  /*! Number of bytes the message needs.
+   *
+   * @return Size of the complete message, including bytes that did not fit
+   *     in a fixed-capacity buffer. Only valid after @ref finish.
+   */
+  size_t required_size() const noexcept { return required_size_; }
+
+  /*! Beginning of the message.
+   *
+   * @return Pointer to the buffer the message is written to.
+   */
+  const char *data() const noexcept;
+
+  //! Number of bytes the buffer can hold without growing.
+  size_t capacity() const noexcept;
+
+  //! Encoding of dense Eigen vectors and matrices.
+  ArrayEncoding array_encoding() const noexcept { return array_encoding_; }
+
+  /*! Set the encoding of dense Eigen vectors and matrices.
+   *
+   * @param[in] encoding New encoding, kept across calls to @ref reset.
+   *
+   * Writing Eigen::Vector2d, Eigen::Vector3d, Eigen::VectorXd and
+   * Eigen::Matrix3d values as binary blobs (see @ref ArrayEncoding) is
+   * opt-in, as MessagePack readers other than this library's need to know
+   * the blob layout to decode them.
+   */
+  void set_array_encoding(ArrayEncoding encoding) noexcept {
+    array_encoding_ = encoding;
+  }
+
   //! Get pointer to the MPack writer for use with the C API.
   mpack_writer_t *mpack_writer() { return &writer_; }
 
  private:
+  //! Initialize the MPack writer for a new message.
+  void init_();
+
+  /*! Flush function of writers to the buffer they own.
+   *
+   * @param[in, out] writer MPack writer whose buffer is full.
+   * @param[in] data Data to flush.
+   * @param[in] count Number of bytes to flush.
+   */
+  static void owned_buffer_flush_(mpack_writer_t *writer, const char *data,
+                                  size_t count);
+
+  //! State of a writer to a fixed-capacity buffer.
+  struct FixedBuffer {
+    //! Caller-provided memory, nullptr if writing to a vector.
+    char *data = nullptr;
+
+    //! Number of bytes available at @ref data.
+    size_t capacity = 0;
+
+    //! Number of bytes of the message written to @ref data.
+    size_t size = 0;
+
+    //! Number of bytes of the message that did not fit.
+    size_t overflow = 0;
+
+    //! Buffer that bytes are written to (then discarded) once data is full.
+    char scratch[64];
+  };
+
+  /*! Flush function of writers to fixed-capacity buffers.
+   *
+   * @param[in, out] writer MPack writer whose buffer is full.
+   * @param[in] data Data to flush.
+   * @param[in] count Number of bytes to flush.
+   */
+  static void fixed_buffer_flush_(mpack_writer_t *writer, const char *data,
+                                  size_t count);
+
   //! Internal MPack writer.
   mpack_writer_t writer_;
 
+  //! Vector of bytes, if any.
+  std::vector<char> *vector_ = nullptr;
+
+  //! Fixed-capacity buffer, if any.
+  FixedBuffer fixed_;
+
+  //! Buffer owned by the writer, if any.
+  std::unique_ptr<char[]> owned_;
+
+  //! Number of bytes at @ref owned_.
+  size_t owned_capacity_ = 0;
+
+  //! Encoding of dense Eigen vectors and matrices.
+  ArrayEncoding array_encoding_ = ArrayEncoding::kArray;
+
+  //! Whether @ref finish has been called since the last initialization.
+  bool finished_ = false;
+
+  //! Number of bytes the message needs, set by @ref finish.
+  size_t required_size_ = 0;
+
   //! Internal write function for tuples.
   template <size_t i, typename... Args,
             typename std::enable_if<i<sizeof...(Args), int>::type = 0> void
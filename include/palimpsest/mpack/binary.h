@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <mpack.h>
+
+#include <Eigen/Core>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "palimpsest/exceptions/TypeError.h"
+#include "palimpsest/mpack/resize.h"
+
+namespace palimpsest::mpack {
+
+/*! Encoding of dense Eigen vectors and matrices.
+ *
+ * Binary blobs hold, in this order:
+ *
+ * - the number of rows, as a little-endian 32-bit unsigned integer,
+ * - the number of columns, as a little-endian 32-bit unsigned integer,
+ * - the coefficients, as little-endian doubles in column-major order (the
+ *   default storage order of Eigen).
+ *
+ * Encoding or decoding a blob copies all coefficients at once, rather than
+ * writing or parsing one MessagePack double per coefficient. Blobs can be
+ * decoded in Python by e.g. ``numpy.frombuffer(blob, "<f8", offset=8)``.
+ */
+enum class ArrayEncoding {
+  //! MessagePack array of doubles (default).
+  kArray,
+
+  //! MessagePack binary blob of raw little-endian doubles with their shape.
+  kBinary
+};
+
+//! Number of bytes of the shape at the beginning of a binary blob.
+constexpr size_t kBinaryShapeSize = 8;
+
+//! Whether objects of type T can be encoded as binary blobs.
+template <typename T>
+inline constexpr bool has_binary_encoding = false;
+
+//! Specialization of @ref has_binary_encoding<T>
+template <>
+inline constexpr bool has_binary_encoding<Eigen::Vector2d> = true;
+
+//! Specialization of @ref has_binary_encoding<T>
+template <>
+inline constexpr bool has_binary_encoding<Eigen::Vector3d> = true;
+
+//! Specialization of @ref has_binary_encoding<T>
+template <>
+inline constexpr bool has_binary_encoding<Eigen::VectorXd> = true;
+
+//! Specialization of @ref has_binary_encoding<T>
+template <>
+inline constexpr bool has_binary_encoding<Eigen::Matrix3d> = true;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+//! Whether doubles are stored in little-endian byte order in memory.
+inline constexpr bool kLittleEndianDoubles = false;
+#else
+//! Whether doubles are stored in little-endian byte order in memory.
+inline constexpr bool kLittleEndianDoubles = true;
+#endif
+
+/*! Copy doubles from or to little-endian bytes.
+ *
+ * @param[out] dest Destination bytes.
+ * @param[in] src Source bytes.
+ * @param[in] count Number of doubles to copy.
+ *
+ * Swapping the byte order is its own inverse, so that this function both
+ * encodes and decodes.
+ */
+inline void copy_little_endian(char* dest, const char* src, size_t count) {
+  if constexpr (kLittleEndianDoubles) {
+    std::memcpy(dest, src, count * sizeof(double));
+  } else {
+    for (size_t i = 0; i < count * sizeof(double); i += sizeof(double)) {
+      for (size_t b = 0; b < sizeof(double); ++b) {
+        dest[i + b] = src[i + sizeof(double) - 1 - b];
+      }
+    }
+  }
+}
+
+/*! Write coefficients as a binary blob.
+ *
+ * @param[out] writer MPack writer.
+ * @param[in] data Coefficients in column-major order.
+ * @param[in] rows Number of rows.
+ * @param[in] cols Number of columns.
+ */
+inline void write_binary(mpack_writer_t* writer, const double* data,
+                         uint32_t rows, uint32_t cols) {
+  const size_t count = static_cast<size_t>(rows) * cols;
+  char shape[kBinaryShapeSize];
+  for (unsigned b = 0; b < 4; ++b) {
+    shape[b] = static_cast<char>((rows >> (8 * b)) & 0xff);
+    shape[4 + b] = static_cast<char>((cols >> (8 * b)) & 0xff);
+  }
+  mpack_start_bin(writer, static_cast<uint32_t>(kBinaryShapeSize +
+                                                count * sizeof(double)));
+  mpack_write_bytes(writer, shape, sizeof(shape));
+  const char* bytes = reinterpret_cast<const char*>(data);
+  if constexpr (kLittleEndianDoubles) {
+    mpack_write_bytes(writer, bytes, count * sizeof(double));
+  } else {
+    char swapped[sizeof(double)];
+    for (size_t i = 0; i < count; ++i) {
+      copy_little_endian(swapped, bytes + i * sizeof(double), 1);
+      mpack_write_bytes(writer, swapped, sizeof(swapped));
+    }
+  }
+  mpack_finish_bin(writer);
+}
+
+/*! Write a dense Eigen vector or matrix as a binary blob.
+ *
+ * @param[out] writer MPack writer.
+ * @param[in] value Vector or matrix to write.
+ */
+template <typename T>
+void write_binary(mpack_writer_t* writer, const T& value) {
+  static_assert(has_binary_encoding<T>, "Type has no binary encoding");
+  write_binary(writer, value.data(), static_cast<uint32_t>(value.rows()),
+               static_cast<uint32_t>(value.cols()));
+}
+
+/*! Read the shape of a binary blob.
+ *
+ * @param[in] data Binary blob.
+ * @param[in] size Number of bytes of the blob.
+ * @param[out] rows Number of rows.
+ * @param[out] cols Number of columns.
+ * @return True if the size of the blob matches its shape.
+ */
+inline bool read_binary_shape(const char* data, size_t size, uint32_t& rows,
+                              uint32_t& cols) {
+  if (size < kBinaryShapeSize) {
+    return false;
+  }
+  rows = 0;
+  cols = 0;
+  for (unsigned b = 0; b < 4; ++b) {
+    rows |= static_cast<uint32_t>(static_cast<uint8_t>(data[b])) << (8 * b);
+    cols |= static_cast<uint32_t>(static_cast<uint8_t>(data[4 + b]))
+            << (8 * b);
+  }
+  const uint64_t count = static_cast<uint64_t>(rows) * cols;
+  return size == kBinaryShapeSize + count * sizeof(double);
+}
+
+/*! Decode a binary blob into a dense Eigen vector or matrix.
+ *
+ * @param[in] data Binary blob.
+ * @param[in] size Number of bytes of the blob.
+ * @param[out] value Vector or matrix to write the coefficients to.
+ * @return True if the blob was decoded, false if its shape does not match
+ *     that of @p value, which is then left unchanged.
+ *
+ * Like arrays, blobs update dynamic vectors without resizing them.
+ */
+template <typename T>
+bool decode_binary(const char* data, size_t size, T& value) {
+  static_assert(has_binary_encoding<T>, "Type has no binary encoding");
+  uint32_t rows = 0;
+  uint32_t cols = 0;
+  if (!read_binary_shape(data, size, rows, cols) ||
+      static_cast<Eigen::Index>(rows) != value.rows() ||
+      static_cast<Eigen::Index>(cols) != value.cols()) {
+    return false;
+  }
+  copy_little_endian(reinterpret_cast<char*>(value.data()),
+                     data + kBinaryShapeSize, value.size());
+  return true;
+}
+
+/*! Decode a binary blob into a dynamic vector following a resize policy.
+ *
+ * @param[in] data Binary blob.
+ * @param[in] size Number of bytes of the blob.
+ * @param[in, out] value Vector to write the coefficients to.
+ * @param[in] policy What to do if the length of the blob differs from the
+ *     size of @p value.
+ * @return True if the blob was decoded, false if it is not a column vector
+ *     or if its length does not fit @p value under the policy.
+ */
+inline bool decode_binary(const char* data, size_t size,
+                          Eigen::VectorXd& value, ResizePolicy policy) {
+  uint32_t rows = 0;
+  uint32_t cols = 0;
+  size_t kept = 0;
+  if (!read_binary_shape(data, size, rows, cols) || cols != 1 ||
+      !fit_length(rows, value, policy, kept)) {
+    return false;
+  }
+  copy_little_endian(reinterpret_cast<char*>(value.data()),
+                     data + kBinaryShapeSize, kept);
+  return true;
+}
+
+/*! Decode a binary blob into a dense Eigen vector or matrix.
+ *
+ * @param[in] data Binary blob.
+ * @param[in] size Number of bytes of the blob.
+ * @param[in, out] value Vector or matrix to write the coefficients to.
+ * @param[in] policy Resize policy, used if T has one.
+ * @return True if the blob was decoded.
+ */
+template <typename T>
+bool decode_binary(const char* data, size_t size, T& value,
+                   ResizePolicy policy) {
+  if constexpr (has_resize_policy<T>) {
+    return decode_binary(data, size, value, policy);
+  } else {
+    return decode_binary(data, size, value);
+  }
+}
+
+/*! Read a dense Eigen vector or matrix from a binary node.
+ *
+ * @param[in] node MPack node of type bin.
+ * @param[out] value Vector or matrix to write the coefficients to.
+ * @param[in] policy Resize policy of dynamic vectors.
+ *
+ * @throw TypeError if the shape of the blob does not fit that of @p value.
+ */
+template <typename T>
+void read_binary(mpack_node_t node, T& value,
+                 ResizePolicy policy = default_resize_policy<T>) {
+  const size_t size = mpack_node_bin_size(node);
+  if (!decode_binary(mpack_node_bin_data(node), size, value, policy)) {
+    throw exceptions::TypeError(
+        __FILE__, __LINE__,
+        "Binary blob of " + std::to_string(size) +
+            " bytes does not match a " + std::to_string(value.rows()) + "x" +
+            std::to_string(value.cols()) + " matrix");
+  }
+}
+
+/*! Read a dense Eigen vector or matrix from a binary blob in a stream.
+ *
+ * @param[in, out] reader MPack reader positioned at a bin value.
+ * @param[out] value Vector or matrix to write the coefficients to.
+ * @param[in] policy Resize policy of dynamic vectors.
+ *
+ * The reader is flagged with mpack_error_type if the shape of the blob does
+ * not fit that of @p value.
+ */
+template <typename T>
+void expect_binary(mpack_reader_t* reader, T& value,
+                   ResizePolicy policy = default_resize_policy<T>) {
+  const uint32_t size = mpack_expect_bin(reader);
+  const char* data = mpack_read_bytes_inplace(reader, size);
+  if (mpack_reader_error(reader) != mpack_ok) {
+    return;
+  }
+  mpack_done_bin(reader);
+  if (!decode_binary(data, size, value, policy)) {
+    mpack_reader_flag_error(reader, mpack_error_type);
+  }
+}
+
+}  // namespace palimpsest::mpack
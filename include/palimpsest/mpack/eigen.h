@@ -16,6 +16,8 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
+#include "palimpsest/mpack/read_doubles.h"
+
 namespace palimpsest::mpack {
 
 /*! Deserialize an Eigen matrix.
@@ -81,6 +83,9 @@ inline Eigen::Vector3d mpack_node_vector3d(mpack_node_t node) {
 inline Eigen::VectorXd mpack_node_vectorXd(mpack_node_t node) {
   const unsigned length = mpack_node_array_length(node);
   Eigen::VectorXd vector(length);
+  if (read_doubles(node, vector.data(), length)) {
+    return vector;
+  }
   for (Eigen::Index i = 0; i < length; ++i) {
     vector(i) = mpack_node_double(mpack_node_array_at(node, i));
   }
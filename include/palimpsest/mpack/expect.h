@@ -0,0 +1,366 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <mpack.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "palimpsest/exceptions/TypeError.h"
+#include "palimpsest/mpack/binary.h"
+#include "palimpsest/mpack/read_doubles.h"
+#include "palimpsest/mpack/resize.h"
+
+namespace palimpsest {
+
+using exceptions::TypeError;
+
+namespace mpack {
+
+/*! Read a value from a MessagePack stream.
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ *
+ * @throw TypeError if there is no streaming deserialization for type T.
+ *
+ * Unlike @ref read, which reads from a parsed tree, these functions consume
+ * the value from the reader. When the value in the stream does not have the
+ * expected type, the reader is flagged with mpack_error_type and the value is
+ * left unspecified: callers should check @c mpack_reader_error afterwards.
+ */
+template <typename T>
+void expect(mpack_reader_t* reader, T& value) {
+  throw TypeError(
+      __FILE__, __LINE__,
+      std::string("No known streaming deserialization for typeid \"") +
+          typeid(T).name() + "\"");
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, bool& value) {
+  value = mpack_expect_bool(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, int8_t& value) {
+  value = mpack_expect_i8(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, int16_t& value) {
+  value = mpack_expect_i16(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, int32_t& value) {
+  value = mpack_expect_i32(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, int64_t& value) {
+  value = mpack_expect_i64(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, uint8_t& value) {
+  value = mpack_expect_u8(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, uint16_t& value) {
+  value = mpack_expect_u16(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, uint32_t& value) {
+  value = mpack_expect_u32(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, uint64_t& value) {
+  value = mpack_expect_u64(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, float& value) {
+  value = mpack_expect_float(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, double& value) {
+  value = mpack_expect_double(reader);
+}
+
+/*! Read a string from a MessagePack stream following a resize policy.
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[in, out] value String to update.
+ * @param[in] policy What to do if the incoming string exceeds the capacity
+ *     of @p value. The reader is flagged with mpack_error_type if it does and
+ *     the policy is @ref ResizePolicy::kError.
+ *
+ * Strings that fit the capacity are copied in place, without allocating.
+ */
+inline void expect(mpack_reader_t* reader, std::string& value,
+                   ResizePolicy policy) {
+  const uint32_t length = mpack_expect_str(reader);
+  const char* data = mpack_read_bytes_inplace(reader, length);
+  if (mpack_reader_error(reader) != mpack_ok) {
+    return;
+  }
+  size_t kept = 0;
+  if (!fit_length(length, value.capacity(), policy, kept)) {
+    mpack_reader_flag_error(reader, mpack_error_type);
+    return;
+  }
+  value.assign(data, kept);
+  mpack_done_str(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ *
+ * The string keeps its capacity, so that updating it with a string of the
+ * same length does not allocate.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, std::string& value) {
+  expect(reader, value, default_resize_policy<std::string>);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, Eigen::Vector2d& value) {
+  mpack_tag_t tag = mpack_peek_tag(reader);
+  if (mpack_tag_type(&tag) == mpack_type_bin) {
+    expect_binary(reader, value);
+    return;
+  }
+  mpack_expect_array_match(reader, 2);
+  value.x() = mpack_expect_double(reader);
+  value.y() = mpack_expect_double(reader);
+  mpack_done_array(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, Eigen::Vector3d& value) {
+  mpack_tag_t tag = mpack_peek_tag(reader);
+  if (mpack_tag_type(&tag) == mpack_type_bin) {
+    expect_binary(reader, value);
+    return;
+  }
+  mpack_expect_array_match(reader, 3);
+  value.x() = mpack_expect_double(reader);
+  value.y() = mpack_expect_double(reader);
+  value.z() = mpack_expect_double(reader);
+  mpack_done_array(reader);
+}
+
+/*! Read a dynamic vector from a MessagePack stream following a resize
+ * policy.
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[in, out] value Vector to update.
+ * @param[in] policy What to do if the incoming length differs from the size
+ *     of @p value. The reader is flagged with mpack_error_type if it does and
+ *     the policy is @ref ResizePolicy::kError.
+ */
+inline void expect(mpack_reader_t* reader, Eigen::VectorXd& value,
+                   ResizePolicy policy) {
+  mpack_tag_t tag = mpack_peek_tag(reader);
+  if (mpack_tag_type(&tag) == mpack_type_bin) {
+    expect_binary(reader, value, policy);
+    return;
+  }
+  const uint32_t length = mpack_expect_array(reader);
+  if (mpack_reader_error(reader) != mpack_ok) {
+    return;
+  }
+  size_t kept = 0;
+  if (!fit_length(length, value, policy, kept)) {
+    mpack_reader_flag_error(reader, mpack_error_type);
+    return;
+  }
+  if (!expect_doubles(reader, value.data(), kept)) {
+    for (size_t i = 0; i < kept; ++i) {
+      value(i) = mpack_expect_double(reader);
+    }
+  }
+  for (size_t i = kept; i < length; ++i) {
+    mpack_discard(reader);
+  }
+  mpack_done_array(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ *
+ * The length of the array, or the shape of the binary blob, should match
+ * that of the vector: the vector is not resized.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, Eigen::VectorXd& value) {
+  expect(reader, value, default_resize_policy<Eigen::VectorXd>);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, Eigen::Quaterniond& value) {
+  mpack_expect_array_match(reader, 4);
+  value.w() = mpack_expect_double(reader);
+  value.x() = mpack_expect_double(reader);
+  value.y() = mpack_expect_double(reader);
+  value.z() = mpack_expect_double(reader);
+  mpack_done_array(reader);
+}
+
+/*! Specialization of @ref expect<T>(reader, value)
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[out] value Reference to write the value to.
+ */
+template <>
+inline void expect(mpack_reader_t* reader, Eigen::Matrix3d& value) {
+  mpack_tag_t tag = mpack_peek_tag(reader);
+  if (mpack_tag_type(&tag) == mpack_type_bin) {
+    expect_binary(reader, value);
+    return;
+  }
+  mpack_expect_array_match(reader, 9);
+  for (Eigen::Index i = 0; i < 3; ++i) {
+    for (Eigen::Index j = 0; j < 3; ++j) {
+      value(i, j) = mpack_expect_double(reader);
+    }
+  }
+  mpack_done_array(reader);
+}
+
+/*! Read a standard vector from a MessagePack stream following a resize
+ * policy.
+ *
+ * @param[in, out] reader MPack reader positioned at the value.
+ * @param[in, out] value Vector to update.
+ * @param[in] policy What to do if the incoming array exceeds the capacity of
+ *     @p value. It also applies to elements that have a resize policy
+ *     and were already in the vector, while new elements grow to fit. The
+ *     reader is flagged with mpack_error_type if the array does not fit and
+ *     the policy is @ref ResizePolicy::kError.
+ *
+ * Arrays that fit the capacity are read in place, without allocating the
+ * vector's buffer. Elements are updated in place as well.
+ */
+template <typename T>
+void expect(mpack_reader_t* reader, std::vector<T>& value,
+            ResizePolicy policy) {
+  const uint32_t length = mpack_expect_array(reader);
+  if (mpack_reader_error(reader) != mpack_ok) {
+    return;
+  }
+  size_t kept = 0;
+  if (!fit_length(length, value.capacity(), policy, kept)) {
+    mpack_reader_flag_error(reader, mpack_error_type);
+    return;
+  }
+  const size_t old_size = value.size();
+  value.resize(kept);
+  bool done = false;
+  if constexpr (std::is_same_v<T, double>) {
+    done = expect_doubles(reader, value.data(), kept);
+  }
+  for (size_t i = 0; !done && i < kept; ++i) {
+    if constexpr (has_resize_policy<T>) {
+      // New elements have no capacity the policy could apply to
+      const ResizePolicy element_policy =
+          (i < old_size) ? policy : ResizePolicy::kGrow;
+      expect(reader, value[i], element_policy);
+    } else {
+      expect<T>(reader, value[i]);
+    }
+  }
+  for (size_t i = kept; i < length; ++i) {
+    mpack_discard(reader);
+  }
+  mpack_done_array(reader);
+}
+
+}  // namespace mpack
+
+}  // namespace palimpsest
@@ -8,8 +8,13 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "palimpsest/exceptions/TypeError.h"
+#include "palimpsest/mpack/binary.h"
+#include "palimpsest/mpack/read_doubles.h"
+#include "palimpsest/mpack/resize.h"
 
 namespace palimpsest {
 
@@ -268,15 +273,20 @@ inline void read(const mpack_node_t node, double& value) {
   value = mpack_node_double(node);
 }
 
-/*! Specialization of @ref mpack_read<T>(node, value)
+/*! Read a string following a resize policy.
  *
  * @param[in] node MPack node to read the value from.
- * @param[out] value Reference to write the value to.
+ * @param[in, out] value String to update.
+ * @param[in] policy What to do if the incoming string exceeds the capacity
+ *     of @p value.
  *
- * @throw TypeError if there is no deserialization for type T.
+ * @throw TypeError if the node is not a string, or if it exceeds the capacity
+ *     of @p value and the policy is @ref ResizePolicy::kError.
+ *
+ * Strings that fit the capacity are copied in place, without allocating.
  */
-template <>
-inline void read(const mpack_node_t node, std::string& value) {
+inline void read(const mpack_node_t node, std::string& value,
+                 ResizePolicy policy) {
 #ifndef NDEBUG
   if (mpack_node_type(node) != mpack_type_str) {
     throw TypeError(
@@ -285,7 +295,27 @@ inline void read(const mpack_node_t node, std::string& value) {
             mpack_type_to_string(mpack_node_type(node)));
   }
 #endif
-  value = std::string{mpack_node_str(node), mpack_node_strlen(node)};
+  const size_t length = mpack_node_strlen(node);
+  size_t kept = 0;
+  if (!fit_length(length, value.capacity(), policy, kept)) {
+    throw TypeError(__FILE__, __LINE__,
+                    "String of length " + std::to_string(length) +
+                        " exceeds the capacity " +
+                        std::to_string(value.capacity()) + " of the value");
+  }
+  value.assign(mpack_node_str(node), kept);
+}
+
+/*! Specialization of @ref mpack_read<T>(node, value)
+ *
+ * @param[in] node MPack node to read the value from.
+ * @param[out] value Reference to write the value to.
+ *
+ * @throw TypeError if there is no deserialization for type T.
+ */
+template <>
+inline void read(const mpack_node_t node, std::string& value) {
+  read(node, value, default_resize_policy<std::string>);
 }
 
 /*! Specialization of @ref mpack_read<T>(node, value)
@@ -297,6 +327,10 @@ inline void read(const mpack_node_t node, std::string& value) {
  */
 template <>
 inline void read(const mpack_node_t node, Eigen::Vector2d& value) {
+  if (mpack_node_type(node) == mpack_type_bin) {
+    read_binary(node, value);
+    return;
+  }
 #ifndef NDEBUG
   if (mpack_node_type(node) != mpack_type_array) {
     throw TypeError(
@@ -319,6 +353,10 @@ inline void read(const mpack_node_t node, Eigen::Vector2d& value) {
  */
 template <>
 inline void read(const mpack_node_t node, Eigen::Vector3d& value) {
+  if (mpack_node_type(node) == mpack_type_bin) {
+    read_binary(node, value);
+    return;
+  }
 #ifndef NDEBUG
   if (mpack_node_type(node) != mpack_type_array) {
     throw TypeError(
@@ -333,15 +371,23 @@ inline void read(const mpack_node_t node, Eigen::Vector3d& value) {
   read<double>(mpack_node_array_at(node, 2), value.z());
 }
 
-/*! Specialization of @ref mpack_read<T>(node, value)
+/*! Read a dynamic vector following a resize policy.
  *
  * @param[in] node MPack node to read the value from.
- * @param[out] value Reference to write the value to.
+ * @param[in, out] value Vector to update.
+ * @param[in] policy What to do if the incoming length differs from the size
+ *     of @p value.
  *
- * @throw TypeError if there is no deserialization for type T.
+ * @throw TypeError if the node is not an array nor a binary blob, or if its
+ *     length differs from the size of @p value and the policy is
+ *     @ref ResizePolicy::kError.
  */
-template <>
-inline void read(const mpack_node_t node, Eigen::VectorXd& value) {
+inline void read(const mpack_node_t node, Eigen::VectorXd& value,
+                 ResizePolicy policy) {
+  if (mpack_node_type(node) == mpack_type_bin) {
+    read_binary(node, value, policy);
+    return;
+  }
 #ifndef NDEBUG
   if (mpack_node_type(node) != mpack_type_array) {
     throw TypeError(
@@ -350,13 +396,34 @@ inline void read(const mpack_node_t node, Eigen::VectorXd& value) {
             mpack_type_to_string(mpack_node_type(node)));
   }
 #endif
-  const unsigned length = mpack_node_array_length(node);
-  assert(length == value.size());
-  for (size_t i = 0; i < length; ++i) {
+  const size_t length = mpack_node_array_length(node);
+  size_t kept = 0;
+  if (!fit_length(length, value, policy, kept)) {
+    throw TypeError(__FILE__, __LINE__,
+                    "Array of length " + std::to_string(length) +
+                        " does not match a vector of size " +
+                        std::to_string(value.size()));
+  }
+  if (read_doubles(node, value.data(), kept)) {
+    return;
+  }
+  for (size_t i = 0; i < kept; ++i) {
     read<double>(mpack_node_array_at(node, i), value(i));
   }
 }
 
+/*! Specialization of @ref mpack_read<T>(node, value)
+ *
+ * @param[in] node MPack node to read the value from.
+ * @param[out] value Reference to write the value to.
+ *
+ * @throw TypeError if there is no deserialization for type T.
+ */
+template <>
+inline void read(const mpack_node_t node, Eigen::VectorXd& value) {
+  read(node, value, default_resize_policy<Eigen::VectorXd>);
+}
+
 /*! Specialization of @ref mpack_read<T>(node, value)
  *
  * @param[in] node MPack node to read the value from.
@@ -390,6 +457,10 @@ inline void read(const mpack_node_t node, Eigen::Quaterniond& value) {
  */
 template <>
 inline void read(const mpack_node_t node, Eigen::Matrix3d& value) {
+  if (mpack_node_type(node) == mpack_type_bin) {
+    read_binary(node, value);
+    return;
+  }
 #ifndef NDEBUG
   if (mpack_node_type(node) != mpack_type_array) {
     throw TypeError(
@@ -406,6 +477,59 @@ inline void read(const mpack_node_t node, Eigen::Matrix3d& value) {
   }
 }
 
+/*! Read a standard vector following a resize policy.
+ *
+ * @param[in] node MPack node to read the value from.
+ * @param[in, out] value Vector to update.
+ * @param[in] policy What to do if the incoming array exceeds the capacity of
+ *     @p value. It also applies to elements that have a resize policy
+ *     and were already in the vector, while new elements grow to fit.
+ *
+ * @throw TypeError if the node is not an array, if it exceeds the capacity of
+ *     @p value and the policy is @ref ResizePolicy::kError, or if an element
+ *     cannot be deserialized.
+ *
+ * Arrays that fit the capacity are read in place, without allocating the
+ * vector's buffer. Elements are updated in place as well.
+ */
+template <typename T>
+void read(const mpack_node_t node, std::vector<T>& value,
+          ResizePolicy policy) {
+#ifndef NDEBUG
+  if (mpack_node_type(node) != mpack_type_array) {
+    throw TypeError(
+        __FILE__, __LINE__,
+        std::string("Expecting an array, but deserialized node has type ") +
+            mpack_type_to_string(mpack_node_type(node)));
+  }
+#endif
+  const size_t length = mpack_node_array_length(node);
+  size_t kept = 0;
+  if (!fit_length(length, value.capacity(), policy, kept)) {
+    throw TypeError(__FILE__, __LINE__,
+                    "Array of length " + std::to_string(length) +
+                        " exceeds the capacity " +
+                        std::to_string(value.capacity()) + " of the vector");
+  }
+  const size_t old_size = value.size();
+  value.resize(kept);
+  if constexpr (std::is_same_v<T, double>) {
+    if (read_doubles(node, value.data(), kept)) {
+      return;
+    }
+  }
+  for (size_t i = 0; i < kept; ++i) {
+    if constexpr (has_resize_policy<T>) {
+      // New elements have no capacity the policy could apply to
+      const ResizePolicy element_policy =
+          (i < old_size) ? policy : ResizePolicy::kGrow;
+      read(mpack_node_array_at(node, i), value[i], element_policy);
+    } else {
+      read<T>(mpack_node_array_at(node, i), value[i]);
+    }
+  }
+}
+
 }  // namespace mpack
 
 }  // namespace palimpsest
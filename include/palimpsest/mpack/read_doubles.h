@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <mpack.h>
+
+#include <cstddef>
+
+namespace palimpsest::mpack {
+
+/*! Read an array of doubles from a parsed node without per-element checks.
+ *
+ * @param[in] node MPack node to read the array from.
+ * @param[out] values Pointer to the doubles to write.
+ * @param[in] count Number of doubles.
+ * @return True if the node is an array whose first @p count values are
+ *     float64, which have been copied to @p values. False otherwise, in which
+ *     case @p values may have been partially written and callers should fall
+ *     back to reading elements one by one, for instance for arrays that mix
+ *     integers and floating-point numbers.
+ *
+ * The tree parser has already decoded the doubles of the array, so that this
+ * function copies them from the children of the node directly, rather than
+ * going through the bounds and type checks of @c mpack_node_array_at and
+ * @c mpack_node_double for each element.
+ */
+inline bool read_doubles(mpack_node_t node, double *values, size_t count) {
+  if (mpack_node_type(node) != mpack_type_array ||
+      mpack_node_array_length(node) < count) {
+    return false;
+  }
+  const mpack_node_data_t *children = node.data->value.children;
+  bool all_doubles = true;
+  for (size_t i = 0; i < count; ++i) {
+    all_doubles &= (children[i].type == mpack_type_double);
+    values[i] = children[i].value.d;
+  }
+  return all_doubles;
+}
+
+/*! Read consecutive float64 values from a stream.
+ *
+ * @param[in, out] reader MPack reader positioned at the first element of an
+ *     array, for instance after @c mpack_expect_array_match.
+ * @param[out] values Pointer to the doubles to write.
+ * @param[in] count Number of doubles.
+ * @return True if the next @p count values were all float64, in which case
+ *     they have been consumed and decoded to @p values. False otherwise, in
+ *     which case the reader has not moved, @p values may have been partially
+ *     written, and callers should fall back to @c mpack_expect_double.
+ *
+ * Decoding checks the 0xcb tags and byte-swaps the contiguous payload with
+ * AVX2 or SSSE3 kernels if the CPU supports them, which is checked once at
+ * runtime, and a scalar kernel otherwise.
+ *
+ * @note With MPACK_READ_TRACKING, this function always returns false.
+ */
+bool expect_doubles(mpack_reader_t *reader, double *values, size_t count);
+
+/*! Name of the kernel selected by @ref expect_doubles.
+ *
+ * @return One of "avx2", "ssse3" or "scalar".
+ */
+const char *expect_doubles_kernel() noexcept;
+
+}  // namespace palimpsest::mpack
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace palimpsest::mpack {
+
+/*! What to do when an update does not fit the capacity of a dynamic value.
+ *
+ * Strings and standard vectors are updated in place, without allocating, as
+ * long as the incoming length is at most their capacity, which can be set
+ * beforehand with e.g. @c std::string::reserve. Dynamic Eigen vectors have no
+ * capacity beyond their size, so that any other length does not fit them.
+ */
+enum class ResizePolicy {
+  //! Grow the value to the incoming length, which allocates.
+  kGrow,
+
+  /*! Keep the first elements that fit and skip the others, which never
+   * allocates. Dynamic Eigen vectors keep their size: coefficients past the
+   * end of a shorter array are left unchanged.
+   */
+  kTruncate,
+
+  /*! Report a type error, which never allocates: TypeError from trees,
+   * mpack_error_type from streams.
+   */
+  kError
+};
+
+//! Whether objects of type T have a capacity that can be reserved.
+template <typename T>
+inline constexpr bool has_capacity = false;
+
+//! Specialization of @ref has_capacity<T>
+template <>
+inline constexpr bool has_capacity<std::string> = true;
+
+//! Specialization of @ref has_capacity<T>
+template <>
+inline constexpr bool has_capacity<std::vector<double>> = true;
+
+//! Specialization of @ref has_capacity<T>
+template <>
+inline constexpr bool has_capacity<std::vector<std::string>> = true;
+
+//! Specialization of @ref has_capacity<T>
+template <>
+inline constexpr bool has_capacity<std::vector<Eigen::Vector2d>> = true;
+
+//! Specialization of @ref has_capacity<T>
+template <>
+inline constexpr bool has_capacity<std::vector<Eigen::Vector3d>> = true;
+
+//! Specialization of @ref has_capacity<T>
+template <>
+inline constexpr bool has_capacity<std::vector<Eigen::VectorXd>> = true;
+
+//! Specialization of @ref has_capacity<T>
+template <>
+inline constexpr bool has_capacity<std::vector<Eigen::Quaterniond>> = true;
+
+//! Specialization of @ref has_capacity<T>
+template <>
+inline constexpr bool has_capacity<std::vector<Eigen::Matrix3d>> = true;
+
+//! Whether objects of type T are updated following a @ref ResizePolicy.
+template <typename T>
+inline constexpr bool has_resize_policy = has_capacity<T>;
+
+//! Specialization of @ref has_resize_policy<T>
+template <>
+inline constexpr bool has_resize_policy<Eigen::VectorXd> = true;
+
+/*! Resize policy of new objects of type T.
+ *
+ * Dynamic Eigen vectors default to @ref ResizePolicy::kError, so that their
+ * shape is fixed, while strings and standard vectors grow by default.
+ */
+template <typename T>
+inline constexpr ResizePolicy default_resize_policy = ResizePolicy::kGrow;
+
+//! Specialization of @ref default_resize_policy<T>
+template <>
+inline constexpr ResizePolicy default_resize_policy<Eigen::VectorXd> =
+    ResizePolicy::kError;
+
+/*! Length to update a string or standard vector to.
+ *
+ * @param[in] length Incoming length.
+ * @param[in] capacity Length the value can hold without allocating.
+ * @param[in] policy What to do if @p length exceeds @p capacity.
+ * @param[out] kept Number of incoming elements to keep.
+ * @return False if the incoming length does not fit and the policy is
+ *     @ref ResizePolicy::kError.
+ */
+inline bool fit_length(size_t length, size_t capacity, ResizePolicy policy,
+                       size_t &kept) noexcept {
+  if (length <= capacity || policy == ResizePolicy::kGrow) {
+    kept = length;
+    return true;
+  } else if (policy == ResizePolicy::kTruncate) {
+    kept = capacity;
+    return true;
+  }
+  return false;
+}
+
+/*! Number of coefficients to update a dynamic Eigen vector with.
+ *
+ * @param[in] length Incoming length.
+ * @param[in, out] value Vector to update, resized if the policy is
+ *     @ref ResizePolicy::kGrow and the length differs from its size.
+ * @param[in] policy What to do if @p length differs from the vector size.
+ * @param[out] kept Number of incoming coefficients to keep.
+ * @return False if the incoming length does not match and the policy is
+ *     @ref ResizePolicy::kError.
+ */
+inline bool fit_length(size_t length, Eigen::VectorXd &value,
+                       ResizePolicy policy, size_t &kept) {
+  const size_t size = static_cast<size_t>(value.size());
+  if (length == size) {
+    kept = length;
+    return true;
+  } else if (policy == ResizePolicy::kGrow) {
+    value.resize(static_cast<Eigen::Index>(length));
+    kept = length;
+    return true;
+  } else if (policy == ResizePolicy::kTruncate) {
+    kept = (length < size) ? length : size;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace palimpsest::mpack
@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <mpack.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "palimpsest/mpack/Writer.h"
+#include "palimpsest/mpack/write.h"
+
+namespace palimpsest::mpack {
+
+/*! Size of the MessagePack encoding of an unsigned integer.
+ *
+ * @param[in] value Integer to encode.
+ * @return Number of bytes MPack writes for this integer.
+ */
+constexpr size_t uint_size(uint64_t value) noexcept {
+  if (value <= 127) {
+    return 1;  // positive fixint
+  } else if (value <= UINT8_MAX) {
+    return 2;
+  } else if (value <= UINT16_MAX) {
+    return 3;
+  } else if (value <= UINT32_MAX) {
+    return 5;
+  }
+  return 9;
+}
+
+/*! Size of the MessagePack encoding of a signed integer.
+ *
+ * @param[in] value Integer to encode.
+ * @return Number of bytes MPack writes for this integer.
+ *
+ * @note Like MPack, non-negative integers are encoded as unsigned ones.
+ */
+constexpr size_t int_size(int64_t value) noexcept {
+  if (value >= 0) {
+    return uint_size(static_cast<uint64_t>(value));
+  } else if (value >= -32) {
+    return 1;  // negative fixint
+  } else if (value >= INT8_MIN) {
+    return 2;
+  } else if (value >= INT16_MIN) {
+    return 3;
+  } else if (value >= INT32_MIN) {
+    return 5;
+  }
+  return 9;
+}
+
+/*! Size of the MessagePack encoding of a string.
+ *
+ * @param[in] length Length of the string.
+ * @return Number of bytes of the string header and contents.
+ */
+constexpr size_t str_size(size_t length) noexcept {
+  if (length <= 31) {
+    return 1 + length;  // fixstr
+  } else if (length <= UINT8_MAX) {
+    return 2 + length;
+  } else if (length <= UINT16_MAX) {
+    return 3 + length;
+  }
+  return 5 + length;
+}
+
+/*! Size of the MessagePack header of an array or a map.
+ *
+ * @param[in] count Number of elements of the array, or of pairs of the map.
+ * @return Number of bytes of the header.
+ */
+constexpr size_t container_header_size(size_t count) noexcept {
+  if (count <= 15) {
+    return 1;  // fixarray or fixmap
+  } else if (count <= UINT16_MAX) {
+    return 3;
+  }
+  return 5;
+}
+
+/*! Size of the serialization of every object of type T.
+ *
+ * Zero for types whose serialized size depends on the value, such as
+ * integers or strings.
+ */
+template <typename T>
+inline constexpr size_t fixed_serialized_size = 0;
+
+//! Specialization of @ref fixed_serialized_size<T>
+template <>
+inline constexpr size_t fixed_serialized_size<bool> = 1;
+
+//! Specialization of @ref fixed_serialized_size<T>
+template <>
+inline constexpr size_t fixed_serialized_size<float> = 5;
+
+//! Specialization of @ref fixed_serialized_size<T>
+template <>
+inline constexpr size_t fixed_serialized_size<double> = 9;
+
+//! Specialization of @ref fixed_serialized_size<T>
+template <>
+inline constexpr size_t fixed_serialized_size<Eigen::Vector2d> = 1 + 2 * 9;
+
+//! Specialization of @ref fixed_serialized_size<T>
+template <>
+inline constexpr size_t fixed_serialized_size<Eigen::Vector3d> = 1 + 3 * 9;
+
+//! Specialization of @ref fixed_serialized_size<T>
+template <>
+inline constexpr size_t fixed_serialized_size<Eigen::Quaterniond> = 1 + 4 * 9;
+
+//! Specialization of @ref fixed_serialized_size<T>
+template <>
+inline constexpr size_t fixed_serialized_size<Eigen::Matrix3d> = 1 + 9 * 9;
+
+/*! Size of the MessagePack serialization of a value.
+ *
+ * @param[in] value Value to serialize.
+ * @return Number of bytes @ref write<T>(writer, value) produces.
+ *
+ * @throw TypeError if there is no serialization for type T.
+ *
+ * The default implementation serializes the value to a writer of zero
+ * capacity, which counts bytes without storing nor allocating them.
+ * Specializations compute the size directly.
+ */
+template <typename T>
+size_t serialized_size(const T& value) {
+  if constexpr (fixed_serialized_size<T> > 0) {
+    return fixed_serialized_size<T>;
+  } else {
+    Writer writer(nullptr, 0);
+    write<T>(writer.mpack_writer(), value);
+    writer.finish();
+    return writer.required_size();
+  }
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const int8_t& value) {
+  return int_size(value);
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const int16_t& value) {
+  return int_size(value);
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const int32_t& value) {
+  return int_size(value);
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const int64_t& value) {
+  return int_size(value);
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const uint8_t& value) {
+  return uint_size(value);
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const uint16_t& value) {
+  return uint_size(value);
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const uint32_t& value) {
+  return uint_size(value);
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const uint64_t& value) {
+  return uint_size(value);
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const std::string& value) {
+  return str_size(value.size());
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const Eigen::VectorXd& value) {
+  const size_t size = static_cast<size_t>(value.size());
+  return container_header_size(size) + size * fixed_serialized_size<double>;
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const std::vector<std::string>& value) {
+  size_t size = container_header_size(value.size());
+  for (const std::string& str : value) {
+    size += str_size(str.size());
+  }
+  return size;
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const std::vector<double>& value) {
+  return container_header_size(value.size()) +
+         value.size() * fixed_serialized_size<double>;
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const std::vector<Eigen::Vector2d>& value) {
+  return container_header_size(value.size()) +
+         value.size() * fixed_serialized_size<Eigen::Vector2d>;
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const std::vector<Eigen::Vector3d>& value) {
+  return container_header_size(value.size()) +
+         value.size() * fixed_serialized_size<Eigen::Vector3d>;
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const std::vector<Eigen::VectorXd>& value) {
+  size_t size = container_header_size(value.size());
+  for (const Eigen::VectorXd& vec : value) {
+    size += serialized_size(vec);
+  }
+  return size;
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const std::vector<Eigen::Quaterniond>& value) {
+  return container_header_size(value.size()) +
+         value.size() * fixed_serialized_size<Eigen::Quaterniond>;
+}
+
+//! Specialization of @ref serialized_size<T>(value)
+template <>
+inline size_t serialized_size(const std::vector<Eigen::Matrix3d>& value) {
+  return container_header_size(value.size()) +
+         value.size() * fixed_serialized_size<Eigen::Matrix3d>;
+}
+
+}  // namespace palimpsest::mpack
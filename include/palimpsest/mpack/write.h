@@ -14,9 +14,13 @@
 #include <mpack.h>
 #include <palimpsest/exceptions/TypeError.h>
 
+#include <Eigen/Core>
+#include <Eigen/Geometry>
 #include <string>
 #include <vector>
 
+#include "palimpsest/mpack/write_doubles.h"
+
 namespace palimpsest::mpack {
 
 /*
@@ -34,9 +38,10 @@ namespace palimpsest::mpack {
  */
 template <typename T>
 void write(mpack_writer_t* writer, const T& value) {
-  throw TypeError(__FILE__, __LINE__,
-                  std::string("No known serialization function for typeid \"") +
-                      typeid(T).name() + "\"");
+  throw exceptions::TypeError(
+      __FILE__, __LINE__,
+      std::string("No known serialization function for typeid \"") +
+          typeid(T).name() + "\"");
 }
 
 //! Specialization of @ref mpack_write<T>(writer, value)
@@ -118,11 +123,12 @@ inline void write(mpack_writer_t* writer, const std::string& value) {
  */
 template <typename T>
 inline void write_matrix(mpack_writer_t* writer, const T& matrix) {
-  for (Eigen::Index i = 0; i < matrix.rows(); ++i) {
-    for (Eigen::Index j = 0; j < matrix.cols(); ++j) {
-      write<double>(writer, matrix(i, j));
-    }
-  }
+  // Coefficients are written row by row, i.e. in the storage order of the
+  // transpose of a column-major matrix
+  const Eigen::Matrix<double, T::ColsAtCompileTime, T::RowsAtCompileTime>
+      transpose = matrix.transpose();
+  write_doubles(writer, transpose.data(),
+                static_cast<size_t>(transpose.size()));
 }
 
 /*! Write a vector to MPack.
@@ -132,9 +138,7 @@ inline void write_matrix(mpack_writer_t* writer, const T& matrix) {
  */
 template <typename T>
 inline void write_vector(mpack_writer_t* writer, const T& vector) {
-  for (Eigen::Index i = 0; i < vector.size(); ++i) {
-    write<double>(writer, vector(i));
-  }
+  write_doubles(writer, vector.data(), static_cast<size_t>(vector.size()));
 }
 
 //! Specialization of @ref mpack_write<T>(writer, value)
@@ -164,11 +168,9 @@ inline void write(mpack_writer_t* writer, const Eigen::VectorXd& value) {
 //! Specialization of @ref mpack_write<T>(writer, value)
 template <>
 inline void write(mpack_writer_t* writer, const Eigen::Quaterniond& value) {
+  const double coeffs[4] = {value.w(), value.x(), value.y(), value.z()};
   mpack_start_array(writer, 4);
-  write<double>(writer, value.w());
-  write<double>(writer, value.x());
-  write<double>(writer, value.y());
-  write<double>(writer, value.z());
+  write_doubles(writer, coeffs, 4);
   mpack_finish_array(writer);
 }
 
@@ -195,9 +197,7 @@ inline void write(mpack_writer_t* writer,
 template <>
 inline void write(mpack_writer_t* writer, const std::vector<double>& value) {
   mpack_start_array(writer, value.size());
-  for (const double& v : value) {
-    write<double>(writer, v);
-  }
+  write_doubles(writer, value.data(), value.size());
   mpack_finish_array(writer);
 }
 
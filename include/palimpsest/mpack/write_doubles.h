@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#pragma once
+
+#include <mpack.h>
+
+#include <cstddef>
+
+namespace palimpsest::mpack {
+
+/*! Write doubles as consecutive MessagePack float64 values.
+ *
+ * @param[out] writer MPack writer.
+ * @param[in] values Pointer to the doubles.
+ * @param[in] count Number of doubles.
+ *
+ * This function writes the same bytes as calling @c mpack_write_double on
+ * each value, that is, a 0xcb tag followed by the big-endian double, but
+ * encodes them in bulk directly into the buffer of the writer. Byte swapping
+ * uses AVX2 or SSSE3 kernels if the CPU supports them, which is checked once
+ * at runtime, and a scalar kernel otherwise.
+ *
+ * @note With MPACK_WRITE_TRACKING, values are written one at a time.
+ */
+void write_doubles(mpack_writer_t *writer, const double *values, size_t count);
+
+/*! Name of the kernel selected by @ref write_doubles.
+ *
+ * @return One of "avx2", "ssse3" or "scalar".
+ */
+const char *write_doubles_kernel() noexcept;
+
+}  // namespace palimpsest::mpack
@@ -12,18 +12,26 @@
 
 #include "palimpsest/Dictionary.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "palimpsest/exceptions/FrozenError.h"
 #include "palimpsest/exceptions/KeyError.h"
+#include "palimpsest/exceptions/PalimpsestError.h"
 #include "palimpsest/exceptions/TypeError.h"
 #include "palimpsest/mpack/eigen.h"
 
 namespace palimpsest {
 
+using exceptions::FrozenError;
 using exceptions::KeyError;
+using exceptions::PalimpsestError;
 using exceptions::TypeError;
 using mpack::mpack_node_matrix3d;
 using mpack::mpack_node_quaterniond;
@@ -31,14 +39,106 @@ using mpack::mpack_node_vector2d;
 using mpack::mpack_node_vector3d;
 using mpack::mpack_node_vectorXd;
 
-void Dictionary::clear() noexcept {
+namespace {
+
+//! Destroy an MPack tree when leaving the scope, including on exceptions.
+class TreeGuard {
+ public:
+  explicit TreeGuard(mpack_tree_t &tree) : tree_(tree) {}
+  ~TreeGuard() { mpack_tree_destroy(&tree_); }
+  TreeGuard(const TreeGuard &) = delete;
+  TreeGuard &operator=(const TreeGuard &) = delete;
+
+ private:
+  mpack_tree_t &tree_;
+};
+
+}  // namespace
+
+void Dictionary::clear() {
   assert(this->is_map());
+  check_not_frozen_("clear");
   map_.clear();
+  ++generation_;
+}
+
+void Dictionary::freeze() {
+  if (frozen_) {
+    return;
+  }
+  auto arena = std::make_unique<std::pmr::monotonic_buffer_resource>(
+      std::max<size_t>(frozen_bytes_(), 1),
+      resource_ ? resource_ : std::pmr::get_default_resource());
+  Dictionary frozen(resource_);
+  relocate_(frozen, arena.get());
+  value_ = std::move(frozen.value_);
+  map_ = std::move(frozen.map_);
+  arena_ = std::move(arena);
+  frozen_ = true;
+  ++generation_;
+}
+
+void Dictionary::thaw() {
+  if (!frozen_) {
+    return;
+  } else if (!arena_) {
+    throw FrozenError(__FILE__, __LINE__,
+                      "Cannot thaw a dictionary that is not the root of its "
+                      "frozen tree.");
+  }
+  Dictionary thawed(resource_);
+  relocate_(thawed, nullptr);
+  value_ = std::move(thawed.value_);
+  map_ = std::move(thawed.map_);
+  arena_.reset();
+  frozen_ = false;
+  ++generation_;
+}
+
+size_t Dictionary::frozen_bytes_() const {
+  if (this->is_value()) {
+    return value_.allocated_bytes();
+  }
+  size_t bytes = 0;
+  size_t nb_key_chars = 0;
+  for (const auto &key_child : map_) {
+    nb_key_chars += key_child.first.size();
+    bytes += key_child.second.frozen_bytes_();
+  }
+  return bytes + internal::FlatMap<Dictionary>::reserved_bytes(map_.size(),
+                                                               nb_key_chars);
+}
+
+void Dictionary::relocate_(Dictionary &target,
+                           std::pmr::memory_resource *arena) {
+  target.frozen_ = (arena != nullptr);
+  target.generation_ = generation_ + 1;
+  if (this->is_value()) {
+    value_.relocate(target.value_, arena ? arena : resource_);
+    return;
+  }
+  target.map_ = internal::FlatMap<Dictionary>(arena ? arena : resource_);
+  size_t nb_key_chars = 0;
+  for (const auto &key_child : map_) {
+    nb_key_chars += key_child.first.size();
+  }
+  target.map_.reserve(map_.size(), nb_key_chars);
+  for (const auto &key_child : map_) {
+    target.map_.try_emplace(key_child.first, key_child.second.resource_);
+  }
+
+  // Depth-first: each child table is followed by the subtrees of its children
+  auto target_it = target.map_.begin();
+  for (auto key_child : map_) {
+    key_child.second.relocate_((*target_it).second, arena);
+    ++target_it;
+  }
 }
 
 void Dictionary::update(const char *data, size_t size) {
   mpack_tree_t tree;
   mpack_tree_init_data(&tree, data, size);
+  TreeGuard guard(tree);
   mpack_tree_parse(&tree);
   const auto status = mpack_tree_error(&tree);
   if (status != mpack_ok) {
@@ -47,7 +147,18 @@ void Dictionary::update(const char *data, size_t size) {
     return;
   }
   update(mpack_tree_root(&tree));
-  mpack_tree_destroy(&tree);
+}
+
+void Dictionary::update(const char *data, size_t size,
+                        mpack::Parser &parser) {
+  const mpack_node_t root = parser.parse(data, size);
+  const auto status = parser.error();
+  if (status != mpack_ok) {
+    spdlog::error("MPack tree error: \"{}\", skipping Dictionary::update",
+                  mpack_error_to_string(status));
+    return;
+  }
+  update(root);
 }
 
 void Dictionary::update(mpack_node_t node) {
@@ -70,22 +181,156 @@ void Dictionary::update(mpack_node_t node) {
   for (size_t i = 0; i < mpack_node_map_count(node); ++i) {
     const mpack_node_t key_node = mpack_node_map_key_at(node, i);
     const mpack_node_t value_node = mpack_node_map_value_at(node, i);
-    const std::string key = {mpack_node_str(key_node),
-                             mpack_node_strlen(key_node)};
-    auto it = map_.find(key);
-    if (it == map_.end()) {
+    const std::string_view key = {mpack_node_str(key_node),
+                                  mpack_node_strlen(key_node)};
+    Dictionary *child = find_update_child_(i, key);
+    if (child == nullptr) {
       this->insert_at_key_(key, value_node);
-    } else /* (it != map_.end()) */ {
+    } else /* (child != nullptr) */ {
+      try {
+        child->update(value_node);
+      } catch (const TypeError &e) {
+        throw TypeError(e, "(at key \"" + std::string(key) + "\") ");
+      }
+    }
+  }
+}
+
+void Dictionary::stream_update(const char *data, size_t size) {
+  mpack_reader_t reader;
+  mpack_reader_init_data(&reader, data, size);
+  try {
+    update(&reader);
+  } catch (...) {
+    mpack_reader_destroy(&reader);
+    throw;
+  }
+  const auto status = mpack_reader_destroy(&reader);
+  if (status != mpack_ok) {
+    spdlog::error("MPack reader error: \"{}\", Dictionary::stream_update "
+                  "stopped at the error",
+                  mpack_error_to_string(status));
+  }
+}
+
+void Dictionary::update(mpack_reader_t *reader) {
+  if (reader->fill != nullptr) {
+    throw PalimpsestError(__FILE__, __LINE__,
+                          "Cannot update from an MPack reader with a fill "
+                          "function, initialize it with "
+                          "mpack_reader_init_data instead");
+  }
+  mpack_tag_t tag = mpack_peek_tag(reader);
+  if (mpack_reader_error(reader) != mpack_ok) {
+    return;
+  }
+  const mpack_type_t type = mpack_tag_type(&tag);
+  if (type == mpack_type_nil) {
+    mpack_discard(reader);
+    return;
+  }
+
+  if (this->is_value()) {
+    value_.expect(reader);
+    if (mpack_reader_error(reader) == mpack_error_type) {
+      throw TypeError(__FILE__, __LINE__,
+                      std::string("Cannot update value of type ") +
+                          value_.type_name() + " from MessagePack " +
+                          mpack_type_to_string(type));
+    }
+    return;
+  }
+
+  /* Now we have asserted that this->is_map() */
+  if (type != mpack_type_map) {
+    throw TypeError(__FILE__, __LINE__,
+                    std::string("Expecting a map, not ") +
+                        mpack_type_to_string(type));
+  }
+
+  const uint32_t count = mpack_expect_map(reader);
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint32_t length = mpack_expect_str(reader);
+    const char *key_data = mpack_read_bytes_inplace(reader, length);
+    mpack_done_str(reader);
+    if (mpack_reader_error(reader) != mpack_ok) {
+      return;
+    }
+    const std::string_view key = {key_data, length};
+    Dictionary *child = find_update_child_(i, key);
+    if (child == nullptr) {
+      this->insert_at_key_(key, reader);
+    } else /* (child != nullptr) */ {
       try {
-        it->second->update(value_node);
+        child->update(reader);
       } catch (const TypeError &e) {
-        throw TypeError(e, "(at key \"" + key + "\") ");
+        throw TypeError(e, "(at key \"" + std::string(key) + "\") ");
       }
     }
   }
+  mpack_done_map(reader);
 }
 
-void Dictionary::insert_at_key_(const std::string &key,
+Dictionary *Dictionary::find_update_child_(size_t index,
+                                          std::string_view key) {
+  if (!key_order_) {
+    key_order_ = std::make_unique<KeyOrder>();
+    key_order_->generation = generation_;
+  }
+  KeyOrder &order = *key_order_;
+  if (order.generation != generation_) {
+    order.entries.clear();
+    order.keys.clear();
+    order.generation = generation_;
+  }
+
+  if (index < order.entries.size()) {
+    const auto &entry = order.entries[index];
+    if (entry.size == key.size() &&
+        std::memcmp(order.keys.data() + entry.offset, key.data(),
+                    key.size()) == 0) {
+      ++order.stats.hits;
+      return entry.child;
+    }
+    order.keys.resize(entry.offset);
+    order.entries.resize(index);
+  }
+
+  ++order.stats.misses;
+  Dictionary *child = map_.find(key);
+  if (child != nullptr && index == order.entries.size()) {
+    order.entries.push_back({order.keys.size(), key.size(), child});
+    order.keys.insert(order.keys.end(), key.begin(), key.end());
+  }
+  return child;
+}
+
+void Dictionary::insert_at_key_(std::string_view key, mpack_reader_t *reader) {
+  const char *begin = nullptr;
+  const char *end = nullptr;
+  mpack_reader_remaining(reader, &begin);
+  mpack_discard(reader);
+  if (mpack_reader_error(reader) != mpack_ok) {
+    return;
+  }
+  mpack_reader_remaining(reader, &end);
+
+  mpack_tree_t tree;
+  mpack_tree_init_data(&tree, begin, static_cast<size_t>(end - begin));
+  TreeGuard guard(tree);
+  mpack_tree_parse(&tree);
+  const auto status = mpack_tree_error(&tree);
+  if (status != mpack_ok) {
+    throw PalimpsestError(__FILE__, __LINE__,
+                          std::string("MPack tree error \"") +
+                              mpack_error_to_string(status) +
+                              "\" while inserting key \"" +
+                              std::string(key) + "\"");
+  }
+  this->insert_at_key_(key, mpack_tree_root(&tree));
+}
+
+void Dictionary::insert_at_key_(std::string_view key,
                                 const mpack_node_t &value) {
   switch (mpack_node_type(value)) {
     case mpack_type_bool:
@@ -113,7 +358,7 @@ void Dictionary::insert_at_key_(const std::string &key,
         throw TypeError(__FILE__, __LINE__,
                         std::string("Cannot deserialize an empty list "
                                     "(precludes type inference) at key \"") +
-                            key + "\"");
+                            std::string(key) + "\"");
       }
       mpack_node_t first_item = mpack_node_array_at(value, 0);
       mpack_type_t array_type = mpack_node_type(first_item);
@@ -148,11 +393,14 @@ void Dictionary::insert_at_key_(const std::string &key,
                             std::string("Encountered non-array item ") +
                                 mpack_type_to_string(sub_type) +
                                 " while parsing array of arrays at key \"" +
-                                key + "\"");
+                                std::string(key) + "\"");
           }
           unsigned sub_length = mpack_node_array_length(sub_array);
           Eigen::VectorXd &vector = new_vec_vec[index];
           vector.resize(sub_length);
+          if (mpack::read_doubles(sub_array, vector.data(), sub_length)) {
+            continue;
+          }
           for (Eigen::Index j = 0; j < sub_length; ++j) {
             vector(j) = mpack_node_double(mpack_node_array_at(sub_array, j));
           }
@@ -161,7 +409,8 @@ void Dictionary::insert_at_key_(const std::string &key,
         throw TypeError(__FILE__, __LINE__,
                         std::string("Unsupported array of ") +
                             mpack_type_to_string(array_type) +
-                            " elements encountered at key \"" + key + "\"");
+                            " elements encountered at key \"" +
+                            std::string(key) + "\"");
       }
       break;
     }
@@ -169,6 +418,9 @@ void Dictionary::insert_at_key_(const std::string &key,
       this->operator()(key).update(value);
       break;
     case mpack_type_bin:
+      this->insert_binary_at_key_(key, mpack_node_bin_data(value),
+                                  mpack_node_bin_size(value));
+      break;
     case mpack_type_nil:
     default:
       throw TypeError(__FILE__, __LINE__,
@@ -177,48 +429,149 @@ void Dictionary::insert_at_key_(const std::string &key,
   }
 }  // namespace palimpsest
 
+void Dictionary::insert_binary_at_key_(std::string_view key, const char *data,
+                                       size_t size) {
+  uint32_t rows = 0;
+  uint32_t cols = 0;
+  if (!mpack::read_binary_shape(data, size, rows, cols)) {
+    throw TypeError(__FILE__, __LINE__,
+                    std::string("Binary blob of ") + std::to_string(size) +
+                        " bytes is not a valid Eigen array at key \"" +
+                        std::string(key) + "\"");
+  }
+  bool decoded = false;
+  if (rows == 2 && cols == 1) {
+    auto &vector = this->insert<Eigen::Vector2d>(key);
+    decoded = mpack::decode_binary(data, size, vector);
+  } else if (rows == 3 && cols == 1) {
+    auto &vector = this->insert<Eigen::Vector3d>(key);
+    decoded = mpack::decode_binary(data, size, vector);
+  } else if (rows == 3 && cols == 3) {
+    auto &matrix = this->insert<Eigen::Matrix3d>(key);
+    decoded = mpack::decode_binary(data, size, matrix);
+  } else if (cols == 1) {
+    auto &vector = this->insert<Eigen::VectorXd>(key, rows);
+    decoded = mpack::decode_binary(data, size, vector);
+  }
+  if (!decoded) {
+    throw TypeError(__FILE__, __LINE__,
+                    "Unsupported " + std::to_string(rows) + "x" +
+                        std::to_string(cols) +
+                        " binary array encountered at key \"" +
+                        std::string(key) + "\"");
+  }
+}
+
+Dictionary::KeyOrderStats Dictionary::key_order_stats() const noexcept {
+  KeyOrderStats stats;
+  if (key_order_) {
+    stats = key_order_->stats;
+  }
+  for (const auto &key_child : map_) {
+    const KeyOrderStats child_stats = key_child.second.key_order_stats();
+    stats.hits += child_stats.hits;
+    stats.misses += child_stats.misses;
+  }
+  return stats;
+}
+
+void Dictionary::reserve(size_t capacity) {
+  if (!this->is_value()) {
+    throw TypeError(__FILE__, __LINE__, "Object is not a value.");
+  }
+  value_.reserve(capacity);
+}
+
+void Dictionary::set_resize_policy(mpack::ResizePolicy policy) {
+  if (this->is_value()) {
+    if (!value_.has_resize_policy()) {
+      throw TypeError(__FILE__, __LINE__,
+                      std::string("Object of type \"") + value_.type_name() +
+                          "\" has no resize policy.");
+    }
+    value_.resize_policy = policy;
+    return;
+  }
+  for (auto key_child : map_) {
+    Dictionary &child = key_child.second;
+    if (child.is_map() || child.value_.has_resize_policy()) {
+      child.set_resize_policy(policy);
+    }
+  }
+}
+
+mpack::ResizePolicy Dictionary::resize_policy() const {
+  if (!this->is_value()) {
+    throw TypeError(__FILE__, __LINE__, "Object is not a value.");
+  } else if (!value_.has_resize_policy()) {
+    throw TypeError(__FILE__, __LINE__,
+                    std::string("Object of type \"") + value_.type_name() +
+                        "\" has no resize policy.");
+  }
+  return value_.resize_policy;
+}
+
 std::vector<std::string> Dictionary::keys() const noexcept {
   std::vector<std::string> out;
   out.reserve(map_.size());
   for (const auto &key_child : map_) {
-    out.push_back(key_child.first);
+    out.emplace_back(key_child.first);
   }
   return out;
 }
 
-void Dictionary::remove(const std::string &key) noexcept {
-  auto it = map_.find(key);
-  if (it == map_.end()) {
+void Dictionary::remove(std::string_view key) {
+  check_not_frozen_("remove a key from");
+  if (!map_.erase(key)) {
     spdlog::error("[Dictionary::remove] No key to remove at \"{}\"", key);
     return;
   }
-  map_.erase(it);
+  ++generation_;
+}
+
+Dictionary &Dictionary::operator()(std::string_view key) {
+  return this->operator()(Key(key));
 }
 
-Dictionary &Dictionary::operator()(const std::string &key) {
+Dictionary &Dictionary::operator()(const Key &key) {
   if (this->is_value()) {
     throw TypeError(__FILE__, __LINE__,
-                    "Cannot look up at key \"" + key +
+                    "Cannot look up at key \"" + std::string(key.name()) +
                         "\" in non-dictionary object of type \"" +
                         value_.type_name() + "\".");
   }
-  auto [it, _] = map_.try_emplace(key, std::make_unique<Dictionary>());
-  return *it->second;
+  if (frozen_) {
+    Dictionary *child = map_.find(key.name(), key.hash());
+    if (child == nullptr) {
+      check_not_frozen_("add a key to");
+    }
+    return *child;
+  }
+  auto child_inserted =
+      map_.try_emplace_hashed(key.name(), key.hash(), resource_);
+  if (child_inserted.second) {
+    ++generation_;
+  }
+  return child_inserted.first;
+}
+
+const Dictionary &Dictionary::operator()(std::string_view key) const {
+  return this->operator()(Key(key));
 }
 
-const Dictionary &Dictionary::operator()(const std::string &key) const {
+const Dictionary &Dictionary::operator()(const Key &key) const {
   if (this->is_value()) {
     throw TypeError(__FILE__, __LINE__,
-                    "Cannot lookup at key \"" + key +
+                    "Cannot lookup at key \"" + std::string(key.name()) +
                         "\" in non-dictionary object of type \"" +
                         value_.type_name() + "\".");
   }
-  const auto it = map_.find(key);
-  if (it == map_.end()) {
-    throw KeyError(key, __FILE__, __LINE__,
+  const Dictionary *child = map_.find(key.name(), key.hash());
+  if (child == nullptr) {
+    throw KeyError(std::string(key.name()), __FILE__, __LINE__,
                    "Since the dictionary is const it cannot be created.");
   }
-  return *it->second;
+  return *child;
 }
 
 void Dictionary::read(const std::string &filename) {
@@ -248,7 +601,225 @@ size_t Dictionary::serialize(std::vector<char> &buffer) const {
   return writer.finish();
 }
 
+size_t Dictionary::serialize(mpack::Writer &writer) const {
+  writer.reset();
+  serialize_(writer);
+  return writer.finish();
+}
+
+Dictionary::SerializeResult Dictionary::serialize(char *data,
+                                                  size_t capacity) const {
+  mpack::Writer writer(data, capacity);
+  serialize_(writer);
+  SerializeResult result;
+  result.size = writer.finish();
+  result.required_size = writer.required_size();
+  return result;
+}
+
+size_t Dictionary::serialize_delta(std::vector<char> &buffer,
+                                   DeltaBaseline &baseline) const {
+  update_delta_baseline_(baseline);
+  mpack::Writer writer(buffer);
+  write_delta_(writer, baseline, 0);
+  return writer.finish();
+}
+
+Dictionary::SerializeResult Dictionary::serialize_delta(
+    char *data, size_t capacity, DeltaBaseline &baseline) const {
+  update_delta_baseline_(baseline);
+  mpack::Writer writer(data, capacity);
+  write_delta_(writer, baseline, 0);
+  SerializeResult result;
+  result.size = writer.finish();
+  result.required_size = writer.required_size();
+  return result;
+}
+
+bool Dictionary::DeltaBaseline::is_valid_for(
+    const Dictionary &dict) const noexcept {
+  // Nodes are checked parent-first, so that a removed child is never
+  // dereferenced: its parent's generation has changed
+  if (root_ != &dict) {
+    return false;
+  }
+  for (const auto &node : nodes_) {
+    if (node.node->generation_ != node.generation) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Dictionary::update_delta_baseline_(DeltaBaseline &baseline) const {
+  mpack::Writer values(baseline.next_bytes_);
+  if (baseline.is_valid_for(*this)) {
+    size_t index = 0;
+    compare_delta_(values, baseline, index);
+  } else {
+    baseline.nodes_.clear();
+    record_delta_(values, baseline);
+    baseline.root_ = this;
+  }
+  values.finish();
+  std::swap(baseline.bytes_, baseline.next_bytes_);
+}
+
+size_t Dictionary::serialized_size() const {
+#if MPACK_WRITE_TRACKING
+  return serialized_size_tree_();
+#else
+  if (!plan_ || !plan_->is_valid()) {
+    compile_plan_();
+  }
+  size_t size = plan_->fixed_size;
+  for (const Value *value : plan_->variable_values) {
+    size += value->serialized_size();
+  }
+  return size;
+#endif
+}
+
+size_t Dictionary::serialized_size_tree_() const {
+  if (this->is_value()) {
+    return value_.serialized_size();
+  }
+  size_t size = mpack::container_header_size(map_.size());
+  for (const auto &key_child : map_) {
+    size += mpack::str_size(key_child.first.size());
+    size += key_child.second.serialized_size_tree_();
+  }
+  return size;
+}
+
 void Dictionary::serialize_(mpack::Writer &writer) const {
+#if MPACK_WRITE_TRACKING
+  serialize_tree_(writer);
+#else
+  if (!plan_ || !plan_->is_valid()) {
+    compile_plan_();
+  }
+  const char *bytes = plan_->bytes.data();
+  for (const auto &step : plan_->steps) {
+    writer.write_bytes(bytes + step.offset, step.size);
+    if (step.value != nullptr) {
+      step.value->serialize(writer);
+    }
+  }
+#endif
+}
+
+void Dictionary::compile_plan_() const {
+  auto plan = std::make_unique<SerializationPlan>();
+  size_t offset = 0;
+  mpack::Writer writer(plan->bytes);
+  compile_(writer, *plan, offset);
+  const size_t size = writer.finish();
+  if (size > offset) {
+    plan->steps.push_back({offset, size - offset, nullptr});
+  }
+  plan->bytes.resize(size);
+  plan->bytes.shrink_to_fit();
+  plan->fixed_size = size;
+  for (const auto &step : plan->steps) {
+    if (step.value == nullptr) {
+      continue;
+    } else if (step.value->has_variable_serialized_size()) {
+      plan->variable_values.push_back(step.value);
+    } else {
+      plan->fixed_size += step.value->serialized_size();
+    }
+  }
+  plan_ = std::move(plan);
+}
+
+void Dictionary::compile_(mpack::Writer &writer, SerializationPlan &plan,
+                          size_t &offset) const {
+  plan.records.push_back({this, generation_});
+  if (this->is_value()) {
+    const size_t used = mpack_writer_buffer_used(writer.mpack_writer());
+    plan.steps.push_back({offset, used - offset, &value_});
+    offset = used;
+    return;
+  }
+  writer.start_map(map_.size());
+  for (const auto &key_child : map_) {
+    writer.write(key_child.first);
+    key_child.second.compile_(writer, plan, offset);
+  }
+  writer.finish_map();
+}
+
+void Dictionary::record_delta_(mpack::Writer &writer,
+                               DeltaBaseline &baseline) const {
+  const size_t index = baseline.nodes_.size();
+  baseline.nodes_.push_back({this, generation_, 0, 0, 0, true});
+  if (this->is_value()) {
+    const size_t offset = mpack_writer_buffer_used(writer.mpack_writer());
+    value_.serialize(writer);
+    const size_t used = mpack_writer_buffer_used(writer.mpack_writer());
+    baseline.nodes_[index].offset = offset;
+    baseline.nodes_[index].size = used - offset;
+  } else {
+    for (const auto &key_child : map_) {
+      key_child.second.record_delta_(writer, baseline);
+    }
+  }
+  baseline.nodes_[index].end = baseline.nodes_.size();
+}
+
+bool Dictionary::compare_delta_(mpack::Writer &writer,
+                                DeltaBaseline &baseline,
+                                size_t &index) const {
+  auto &node = baseline.nodes_[index++];
+  if (this->is_value()) {
+    const size_t offset = mpack_writer_buffer_used(writer.mpack_writer());
+    value_.serialize(writer);
+    const size_t size =
+        mpack_writer_buffer_used(writer.mpack_writer()) - offset;
+    node.changed = (size != node.size ||
+                    std::memcmp(writer.data() + offset,
+                                baseline.bytes_.data() + node.offset,
+                                size) != 0);
+    node.offset = offset;
+    node.size = size;
+    return node.changed;
+  }
+  bool changed = false;
+  for (const auto &key_child : map_) {
+    changed |= key_child.second.compare_delta_(writer, baseline, index);
+  }
+  node.changed = changed;
+  return changed;
+}
+
+void Dictionary::write_delta_(mpack::Writer &writer,
+                              const DeltaBaseline &baseline,
+                              size_t index) const {
+  const auto &nodes = baseline.nodes_;
+  if (this->is_value()) {
+    writer.write_bytes(baseline.bytes_.data() + nodes[index].offset,
+                       nodes[index].size);
+    return;
+  }
+  size_t nb_changed = 0;
+  for (size_t child = index + 1; child < nodes[index].end;
+       child = nodes[child].end) {
+    nb_changed += nodes[child].changed ? 1 : 0;
+  }
+  writer.start_map(nb_changed);
+  size_t child = index + 1;
+  for (const auto &key_child : map_) {
+    if (nodes[child].changed) {
+      writer.write(key_child.first);
+      key_child.second.write_delta_(writer, baseline, child);
+    }
+    child = nodes[child].end;
+  }
+  writer.finish_map();
+}
+
+void Dictionary::serialize_tree_(mpack::Writer &writer) const {
   if (this->is_value()) {
     value_.serialize(writer);
     return;
@@ -257,23 +828,23 @@ void Dictionary::serialize_(mpack::Writer &writer) const {
   writer.start_map(size);
   for (const auto &key_child : map_) {
     const auto &key = key_child.first;
-    const auto &child = *key_child.second;
+    const auto &child = key_child.second;
     writer.write(key);
-    child.serialize_(writer);
+    child.serialize_tree_(writer);
   }
   writer.finish_map();
 }
 
-const Dictionary::Value &Dictionary::get_child_value_(
-    const std::string &key) const {
-  const auto it = map_.find(key);
-  if (it == map_.end()) {
-    throw KeyError(key, __FILE__, __LINE__, "");
-  } else if (!it->second->is_value()) {
+const Dictionary::Value &Dictionary::get_child_value_(const Key &key) const {
+  const Dictionary *child = map_.find(key.name(), key.hash());
+  if (child == nullptr) {
+    throw KeyError(std::string(key.name()), __FILE__, __LINE__, "");
+  } else if (!child->is_value()) {
     throw TypeError(__FILE__, __LINE__,
-                    "Child at key \"" + key + "\" is not a value");
+                    "Child at key \"" + std::string(key.name()) +
+                        "\" is not a value");
   }
-  return it->second->value_;
+  return child->value_;
 }
 
 std::ostream &operator<<(std::ostream &stream, const Dictionary &dict) {
@@ -292,7 +863,7 @@ std::ostream &operator<<(std::ostream &stream, const Dictionary &dict) {
       } else /* is not first key */ {
         stream << ", ";
       }
-      stream << "\"" << key << "\": " << *child;
+      stream << "\"" << key << "\": " << child;
     }
     stream << "}";
   }
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/LogIndex.h"
+
+#include <vector>
+
+namespace palimpsest {
+
+namespace {
+
+//! Append a little-endian 64-bit unsigned integer to a buffer.
+void store(std::uint64_t value, std::vector<char> &bytes) {
+  for (int i = 0; i < 8; ++i) {
+    bytes.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+//! Append the MessagePack header of a bin 32 object to a buffer.
+void store_bin_header(size_t size, std::vector<char> &bytes) {
+  bytes.push_back(static_cast<char>(0xc6));
+  for (int i = 3; i >= 0; --i) {
+    bytes.push_back(static_cast<char>((size >> (8 * i)) & 0xff));
+  }
+}
+
+}  // namespace
+
+void LogIndex::write_block(std::uint64_t offset, std::vector<char> &bytes) {
+  store_bin_header(sizeof(kBlockMagic) + 16 * (1 + pending_.size()), bytes);
+  bytes.insert(bytes.end(), kBlockMagic, kBlockMagic + sizeof(kBlockMagic));
+  store(nb_indexed_frames_, bytes);
+  store(pending_.size(), bytes);
+  for (const Entry &frame : pending_) {
+    store(frame.first, bytes);
+    store(frame.second, bytes);
+  }
+  blocks_.push_back({nb_indexed_frames_, offset});
+  nb_indexed_frames_ += pending_.size();
+  pending_.clear();
+}
+
+void LogIndex::write_footer(std::uint64_t offset, std::vector<char> &bytes) {
+  if (!pending_.empty()) {
+    const size_t size = bytes.size();
+    write_block(offset, bytes);
+    offset += bytes.size() - size;
+  }
+  store_bin_header(sizeof(kFooterMagic) + 16 * (1 + blocks_.size()) +
+                       kTrailerSize,
+                   bytes);
+  bytes.insert(bytes.end(), kFooterMagic,
+               kFooterMagic + sizeof(kFooterMagic));
+  store(nb_indexed_frames_, bytes);
+  store(blocks_.size(), bytes);
+  for (const Entry &block : blocks_) {
+    store(block.first, bytes);
+    store(block.second, bytes);
+  }
+  store(offset, bytes);
+  bytes.insert(bytes.end(), kFooterMagic,
+               kFooterMagic + sizeof(kFooterMagic));
+}
+
+}  // namespace palimpsest
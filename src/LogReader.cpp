@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/LogReader.h"
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "palimpsest/LogIndex.h"
+
+using palimpsest::exceptions::PalimpsestError;
+using palimpsest::exceptions::SystemError;
+
+namespace palimpsest {
+
+namespace {
+
+/*! Get the payload size of a MessagePack bin 32 object.
+ *
+ * @param[in] data Beginning of the object.
+ * @param[out] size Size of the payload.
+ * @return True if the object is a bin 32.
+ */
+bool load_bin_header(const char *data, std::uint64_t &size) {
+  if (static_cast<unsigned char>(data[0]) != 0xc6) {
+    return false;
+  }
+  size = 0;
+  for (int i = 1; i < 5; ++i) {
+    size = (size << 8) | static_cast<unsigned char>(data[i]);
+  }
+  return true;
+}
+
+}  // namespace
+
+LogReader::LogReader(const std::string &path) : path_(path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw SystemError(__FILE__, __LINE__,
+                      "Cannot open \"" + path + "\" for reading", errno);
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    const int error_number = errno;
+    ::close(fd);
+    throw SystemError(__FILE__, __LINE__, "Cannot stat \"" + path + "\"",
+                      error_number);
+  }
+  size_ = static_cast<size_t>(status.st_size);
+  if (size_ > 0) {
+    void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error_number = errno;
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+      throw SystemError(__FILE__, __LINE__, "Cannot map \"" + path + "\"",
+                        error_number);
+    }
+    data_ = static_cast<const char *>(mapping);
+  } else {
+    ::close(fd);
+  }
+  if (!load_footer_()) {
+    scan_();
+  }
+}
+
+LogReader::~LogReader() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+std::string_view LogReader::frame(size_t index) const {
+  if (index >= nb_frames_) {
+    throw std::out_of_range("Frame " + std::to_string(index) + " of \"" +
+                            path_ + "\" is out of range, the log has " +
+                            std::to_string(nb_frames_) + " frames");
+  }
+  if (footer_ == nullptr) {
+    return {data_ + frames_[2 * index], frames_[2 * index + 1]};
+  }
+
+  // Blocks are sorted by first frame, and the first block starts at zero
+  size_t low = 0;
+  size_t high = nb_blocks_;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    if (LogIndex::load(footer_ + 16 * middle) <= index) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  const char *block = footer_ + 16 * (low - 1);
+  const std::uint64_t first_frame = LogIndex::load(block);
+  const char *entry = data_ + LogIndex::load(block + 8) +
+                      LogIndex::kHeaderSize + sizeof(LogIndex::kBlockMagic) +
+                      16 * (1 + index - first_frame);
+  const std::uint64_t offset = LogIndex::load(entry);
+  const std::uint64_t size = LogIndex::load(entry + 8);
+  if (offset > size_ || size > size_ - offset) {
+    throw PalimpsestError(__FILE__, __LINE__,
+                          "Index of \"" + path_ + "\" puts frame " +
+                              std::to_string(index) + " out of the file");
+  }
+  return {data_ + offset, size};
+}
+
+bool LogReader::is_keyframe(size_t index) const {
+  const std::string_view bytes = frame(index);
+  constexpr size_t kMarkerSize = sizeof(LogIndex::kDeltaMarker);
+  return static_cast<size_t>(bytes.data() - data_) < kMarkerSize ||
+         std::memcmp(bytes.data() - kMarkerSize, LogIndex::kDeltaMarker,
+                     kMarkerSize) != 0;
+}
+
+void LogReader::replay(size_t index, Dictionary &dict) const {
+  size_t keyframe = index;
+  while (keyframe > 0 && !is_keyframe(keyframe)) {
+    --keyframe;
+  }
+  for (size_t frame = keyframe; frame <= index; ++frame) {
+    read(frame, dict);
+  }
+}
+
+bool LogReader::load_footer_() {
+  constexpr size_t kMinBlockSize =
+      LogIndex::kHeaderSize + sizeof(LogIndex::kBlockMagic) + 16;
+  constexpr size_t kMinFooterSize = LogIndex::kHeaderSize +
+                                    sizeof(LogIndex::kFooterMagic) + 16 +
+                                    LogIndex::kTrailerSize;
+  if (size_ < kMinFooterSize) {
+    return false;
+  }
+  const char *trailer = data_ + size_ - LogIndex::kTrailerSize;
+  if (std::memcmp(trailer + 8, LogIndex::kFooterMagic,
+                  sizeof(LogIndex::kFooterMagic)) != 0) {
+    return false;
+  }
+  const std::uint64_t offset = LogIndex::load(trailer);
+  std::uint64_t length = 0;
+  if (offset > size_ - kMinFooterSize ||
+      !load_bin_header(data_ + offset, length) ||
+      offset + LogIndex::kHeaderSize + length != size_) {
+    return false;
+  }
+  const char *payload = data_ + offset + LogIndex::kHeaderSize;
+  const std::uint64_t nb_frames = LogIndex::load(payload + 8);
+  const std::uint64_t nb_blocks = LogIndex::load(payload + 16);
+  if (std::memcmp(payload, LogIndex::kFooterMagic,
+                  sizeof(LogIndex::kFooterMagic)) != 0 ||
+      nb_blocks > length / 16 ||
+      length != kMinFooterSize - LogIndex::kHeaderSize + 16 * nb_blocks) {
+    return false;
+  }
+
+  // Check block headers, so that frame lookups only read valid blocks
+  const char *blocks = payload + sizeof(LogIndex::kFooterMagic) + 16;
+  std::uint64_t next_frame = 0;
+  for (std::uint64_t i = 0; i < nb_blocks; ++i) {
+    const std::uint64_t first_frame = LogIndex::load(blocks + 16 * i);
+    const std::uint64_t block_offset = LogIndex::load(blocks + 16 * i + 8);
+    if (first_frame != next_frame || block_offset >= offset ||
+        offset - block_offset < kMinBlockSize ||
+        !load_bin_header(data_ + block_offset, length)) {
+      return false;
+    }
+    const char *block = data_ + block_offset + LogIndex::kHeaderSize;
+    const std::uint64_t nb_block_frames = LogIndex::load(block + 16);
+    const std::uint64_t block_length =
+        kMinBlockSize - LogIndex::kHeaderSize + 16 * nb_block_frames;
+    if (std::memcmp(block, LogIndex::kBlockMagic,
+                    sizeof(LogIndex::kBlockMagic)) != 0 ||
+        LogIndex::load(block + 8) != first_frame ||
+        nb_block_frames > length / 16 ||
+        length != block_length ||
+        length > offset - block_offset - LogIndex::kHeaderSize) {
+      return false;
+    }
+    next_frame += nb_block_frames;
+  }
+  if (next_frame != nb_frames) {
+    return false;
+  }
+  footer_ = blocks;
+  nb_blocks_ = nb_blocks;
+  nb_frames_ = nb_frames;
+  return true;
+}
+
+void LogReader::scan_() {
+  mpack_reader_t reader;
+  mpack_reader_init_data(&reader, data_, size_);
+  size_t remaining = size_;
+  while (remaining > 0) {
+    const size_t offset = size_ - remaining;
+    mpack_tag_t tag = mpack_peek_tag(&reader);
+    mpack_discard(&reader);
+    if (mpack_reader_error(&reader) != mpack_ok) {
+      spdlog::warn("Ignoring the last {} bytes of \"{}\", which are not a "
+                   "complete frame",
+                   remaining, path_);
+      break;
+    }
+
+    // Frames are never binary objects, while index blocks always are
+    remaining = mpack_reader_remaining(&reader, nullptr);
+    if (mpack_tag_type(&tag) != mpack_type_bin) {
+      frames_.push_back(offset);
+      frames_.push_back(size_ - remaining - offset);
+    }
+  }
+  mpack_reader_destroy(&reader);
+  nb_frames_ = frames_.size() / 2;
+}
+
+}  // namespace palimpsest
@@ -0,0 +1,300 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/Logger.h"
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using palimpsest::exceptions::SystemError;
+
+namespace palimpsest {
+
+namespace {
+
+//! Alignment of slots, a common cache-line size.
+constexpr size_t kAlignment = 64;
+
+//! Maximum number of frames written with one system call (IOV_MAX on Linux).
+constexpr size_t kMaxBatchFrames = 1024;
+
+}  // namespace
+
+Logger::Logger(const std::string &path, size_t frame_capacity,
+               size_t nb_slots, SyncPolicy sync_policy,
+               std::chrono::milliseconds sync_period, size_t index_interval)
+    : path_(path),
+      frame_capacity_(frame_capacity),
+      nb_slots_(std::max<size_t>(nb_slots, 1)),
+      slot_stride_((frame_capacity + kAlignment - 1) / kAlignment *
+                   kAlignment),
+      batch_size_(std::max<size_t>(nb_slots_ / 4, 1)),
+      sync_policy_(sync_policy),
+      sync_period_(sync_period),
+      last_sync_(std::chrono::steady_clock::now()),
+      slots_(std::make_unique<char[]>(nb_slots_ * slot_stride_)),
+      sizes_(nb_slots_, 0),
+      marker_sizes_(nb_slots_, 0) {
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    throw SystemError(__FILE__, __LINE__,
+                      "Cannot open \"" + path + "\" for writing", errno);
+  }
+  if (index_interval > 0) {
+    index_ = std::make_unique<LogIndex>(index_interval);
+  }
+  thread_ = std::thread(&Logger::run_, this);
+}
+
+Logger::~Logger() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+  ::close(fd_);
+}
+
+bool Logger::write(const Dictionary &dict) {
+  const std::uint64_t head = head_.load(std::memory_order_relaxed);
+  const size_t depth = head - tail_.load(std::memory_order_acquire);
+  if (depth >= nb_slots_) {
+    dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  char *data = slot_data_(head);
+  if (keyframe_interval_ == 0) {
+    const Dictionary::SerializeResult result =
+        dict.serialize(data, frame_capacity_);
+    if (result.insufficient_capacity()) {
+      dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    publish_(head, 0, result.size, depth);
+    return true;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  size_t marker_size = sizeof(LogIndex::kDeltaMarker);
+  if ((force_keyframe_.load(std::memory_order_relaxed) &&
+       force_keyframe_.exchange(false, std::memory_order_relaxed)) ||
+      !baseline_.is_valid_for(dict) ||
+      nb_frames_since_keyframe_ >= keyframe_interval_ ||
+      now - last_keyframe_ >= keyframe_period_) {
+    baseline_.reset();  // all values of the next frame are new
+    marker_size = 0;
+  }
+  Dictionary::SerializeResult result;
+  if (marker_size <= frame_capacity_) {
+    std::memcpy(data, LogIndex::kDeltaMarker, marker_size);
+    result = dict.serialize_delta(data + marker_size,
+                                  frame_capacity_ - marker_size, baseline_);
+  }
+  if (marker_size > frame_capacity_ || result.insufficient_capacity()) {
+    baseline_.reset();
+    dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (marker_size == 0) {
+    last_keyframe_ = now;
+    nb_frames_since_keyframe_ = 0;
+  }
+  ++nb_frames_since_keyframe_;
+  publish_(head, marker_size, marker_size + result.size, depth);
+  return true;
+}
+
+bool Logger::write(const char *data, size_t size) {
+  const std::uint64_t head = head_.load(std::memory_order_relaxed);
+  const size_t depth = head - tail_.load(std::memory_order_acquire);
+  if (depth >= nb_slots_ || size > frame_capacity_) {
+    dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  std::memcpy(slot_data_(head), data, size);
+  baseline_.reset();
+  publish_(head, 0, size, depth);
+  return true;
+}
+
+void Logger::publish_(std::uint64_t head, size_t marker_size, size_t size,
+                      size_t depth) {
+  sizes_[head % nb_slots_] = size;
+  marker_sizes_[head % nb_slots_] = marker_size;
+  head_.store(head + 1, std::memory_order_release);
+  if (depth + 1 > max_queue_depth_.load(std::memory_order_relaxed)) {
+    max_queue_depth_.store(depth + 1, std::memory_order_relaxed);
+  }
+
+  // The background thread also wakes up periodically, so that a
+  // notification missed while it was not waiting only delays the batch
+  if (depth + 1 == batch_size_) {
+    wake_.notify_one();
+  }
+}
+
+void Logger::run_() {
+  for (bool stopping = false; !stopping;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!stop_ && queue_depth() < batch_size_) {
+        wake_.wait_for(lock, kWritePeriod);
+      }
+      stopping = stop_;
+    }
+
+    // Frames published before the stop request are all visible here
+    std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    const bool has_written = (tail != head);
+    while (tail != head) {
+      tail += write_batch_(tail, head);
+      tail_.store(tail, std::memory_order_release);
+    }
+    if (index_ && index_->has_full_block()) {
+      index_bytes_.clear();
+      index_->write_block(file_offset_, index_bytes_);
+      write_all_(index_bytes_.data(), index_bytes_.size());
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (has_written && sync_policy_ == SyncPolicy::kEveryBatch) {
+      sync_(now);
+    } else if (sync_policy_ == SyncPolicy::kPeriodic &&
+               now - last_sync_ >= sync_period_) {
+      sync_(now);
+    }
+  }
+  if (index_) {
+    index_bytes_.clear();
+    index_->write_footer(file_offset_, index_bytes_);
+    write_all_(index_bytes_.data(), index_bytes_.size());
+  }
+  if (sync_policy_ != SyncPolicy::kNone) {
+    sync_(std::chrono::steady_clock::now());
+  }
+}
+
+size_t Logger::write_batch_(std::uint64_t tail, std::uint64_t head) {
+  const size_t nb_frames = std::min<size_t>(head - tail, kMaxBatchFrames);
+  struct iovec frames[kMaxBatchFrames];
+  size_t slots[kMaxBatchFrames];
+  size_t nb_left = 0;
+  if (write_failed_) {
+    dropped_frames_.fetch_add(nb_frames, std::memory_order_relaxed);
+    return nb_frames;
+  }
+  for (size_t i = 0; i < nb_frames; ++i) {
+    const size_t slot = (tail + i) % nb_slots_;
+    if (skip_deltas_ && marker_sizes_[slot] > 0) {
+      // Delta from a frame that did not reach the file
+      dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    skip_deltas_ = false;
+    frames[nb_left].iov_base = slot_data_(tail + i);
+    frames[nb_left].iov_len = sizes_[slot];
+    slots[nb_left] = slot;
+    ++nb_left;
+  }
+
+  // Frames are only released once written, so that partial writes resume
+  // from the slots
+  struct iovec *next = frames;
+  while (nb_left > 0) {
+    const ssize_t written = ::writev(fd_, next, static_cast<int>(nb_left));
+    if (written < 0 && errno == EINTR) {
+      continue;
+    } else if (written < 0) {
+      spdlog::error("Cannot write to \"{}\": {}, dropping {} frames", path_,
+                    std::strerror(errno), nb_left);
+      dropped_frames_.fetch_add(nb_left, std::memory_order_relaxed);
+
+      // Remove the bytes of a partially written frame, which would make
+      // sequential readers lose track of the frames after it
+      const size_t partial_bytes = sizes_[slots[next - frames]] - next->iov_len;
+      truncate_(file_offset_ - partial_bytes);
+
+      // Deltas from the dropped frames would not reconstruct their values
+      skip_deltas_ = true;
+      force_keyframe_.store(true, std::memory_order_relaxed);
+      break;
+    }
+    size_t bytes = static_cast<size_t>(written);
+    while (nb_left > 0 && bytes >= next->iov_len) {
+      const size_t slot = slots[next - frames];
+      const size_t size = sizes_[slot];
+      const std::uint64_t offset = file_offset_ + next->iov_len - size;
+      if (index_) {  // frames start after their delta marker
+        const size_t marker_size = marker_sizes_[slot];
+        index_->add_frame(offset + marker_size, size - marker_size);
+      }
+      file_offset_ = offset + size;
+      bytes -= next->iov_len;
+      written_frames_.fetch_add(1, std::memory_order_relaxed);
+      ++next;
+      --nb_left;
+    }
+    if (nb_left > 0) {  // bytes of a partially written frame
+      next->iov_base = static_cast<char *>(next->iov_base) + bytes;
+      next->iov_len -= bytes;
+      file_offset_ += bytes;
+    }
+  }
+  return nb_frames;
+}
+
+void Logger::write_all_(const char *data, size_t size) {
+  if (write_failed_) {
+    return;
+  }
+  const std::uint64_t start_offset = file_offset_;
+  while (size > 0) {
+    const ssize_t written = ::write(fd_, data, size);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    } else if (written < 0) {
+      spdlog::error("Cannot write index to \"{}\": {}", path_,
+                    std::strerror(errno));
+      truncate_(start_offset);
+      return;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+    file_offset_ += static_cast<std::uint64_t>(written);
+  }
+}
+
+void Logger::truncate_(std::uint64_t offset) {
+  if (offset == file_offset_) {
+    return;
+  }
+  const off_t length = static_cast<off_t>(offset);
+  if (::ftruncate(fd_, length) != 0 || ::lseek(fd_, length, SEEK_SET) < 0) {
+    spdlog::error("Cannot remove partial write from \"{}\": {}, "
+                  "dropping all further frames",
+                  path_, std::strerror(errno));
+    write_failed_ = true;
+    return;
+  }
+  file_offset_ = offset;
+}
+
+void Logger::sync_(std::chrono::steady_clock::time_point now) {
+  if (::fsync(fd_) != 0) {
+    spdlog::error("Cannot sync \"{}\" to disk: {}", path_,
+                  std::strerror(errno));
+  }
+  last_sync_ = now;
+}
+
+}  // namespace palimpsest
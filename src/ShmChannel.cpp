@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/ShmChannel.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "palimpsest/exceptions/PalimpsestError.h"
+
+using palimpsest::exceptions::PalimpsestError;
+using palimpsest::exceptions::SystemError;
+
+namespace palimpsest {
+
+namespace {
+
+//! Alignment of the header and slots, a common cache-line size.
+constexpr size_t kAlignment = 64;
+
+//! Round a size up to the next multiple of @ref kAlignment.
+constexpr size_t align_up(size_t size) noexcept {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+}  // namespace
+
+ShmChannel::ShmChannel(const std::string &name, size_t capacity)
+    : name_(name), capacity_(capacity), is_writer_(true) {
+  // Start from a new object, so that readers of a previous one are unaffected
+  ::shm_unlink(name.c_str());
+  const int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    throw SystemError(__FILE__, __LINE__,
+                      "Cannot create shared memory \"" + name + "\"", errno);
+  }
+  const size_t size = mapped_size_(capacity);
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    const int error_number = errno;
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    throw SystemError(__FILE__, __LINE__,
+                      "Cannot resize shared memory \"" + name + "\"",
+                      error_number);
+  }
+  try {
+    map_(fd, size, /* writable = */ true);
+  } catch (...) {
+    ::shm_unlink(name.c_str());
+    throw;
+  }
+
+  // The new object is zero-filled: frame numbers and sequences start at zero
+  header_->version = kVersion;
+  header_->capacity = capacity;
+  header_->magic.store(kMagic, std::memory_order_release);
+  buffer_.resize(capacity);
+}
+
+ShmChannel::ShmChannel(const std::string &name) : name_(name) {
+  const int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    throw SystemError(__FILE__, __LINE__,
+                      "Cannot open shared memory \"" + name + "\"", errno);
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    const int error_number = errno;
+    ::close(fd);
+    throw SystemError(__FILE__, __LINE__,
+                      "Cannot stat shared memory \"" + name + "\"",
+                      error_number);
+  }
+  const size_t size = static_cast<size_t>(status.st_size);
+  if (size < sizeof(Header)) {
+    ::close(fd);
+    throw SystemError(__FILE__, __LINE__,
+                      "Shared memory \"" + name + "\" is not a channel");
+  }
+  map_(fd, size, /* writable = */ false);
+  if (header_->magic.load(std::memory_order_acquire) != kMagic ||
+      header_->version != kVersion ||
+      mapped_size_(header_->capacity) > size) {
+    ::munmap(mapping_, mapped_bytes_);
+    throw SystemError(__FILE__, __LINE__,
+                      "Shared memory \"" + name +
+                          "\" is not a channel of version " +
+                          std::to_string(kVersion));
+  }
+  capacity_ = header_->capacity;
+  buffer_.resize(capacity_);
+}
+
+ShmChannel::~ShmChannel() {
+  ::munmap(mapping_, mapped_bytes_);
+  if (is_writer_) {
+    ::shm_unlink(name_.c_str());
+  }
+}
+
+Dictionary::SerializeResult ShmChannel::write(const Dictionary &dict) {
+  check_writer_();
+  Slot &slot = begin_write_();
+  const Dictionary::SerializeResult result =
+      dict.serialize(slot_data_(slot), capacity_);
+  if (result.insufficient_capacity()) {
+    abort_write_(slot);
+  } else {
+    end_write_(slot, result.size);
+  }
+  return result;
+}
+
+bool ShmChannel::write(const char *data, size_t size) {
+  check_writer_();
+  if (size > capacity_) {
+    return false;
+  }
+  Slot &slot = begin_write_();
+  std::memcpy(slot_data_(slot), data, size);
+  end_write_(slot, size);
+  return true;
+}
+
+size_t ShmChannel::read(char *data) {
+  for (unsigned attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+    const std::uint64_t latest =
+        header_->frame.load(std::memory_order_acquire);
+    if (latest == last_read_frame_) {
+      return 0;
+    }
+    Slot &slot = slot_(latest);
+    const std::uint64_t sequence =
+        slot.sequence.load(std::memory_order_acquire);
+    if (sequence & 1) {
+      // The writer has moved on to the next frame in this slot, let it run
+      std::this_thread::yield();
+      continue;
+    }
+    const std::uint64_t frame = slot.frame.load(std::memory_order_relaxed);
+    const std::uint64_t size = slot.size.load(std::memory_order_relaxed);
+    if (size > capacity_) {
+      // The writer never publishes such sizes, retrying would not help
+      throw PalimpsestError(__FILE__, __LINE__,
+                            "Slot of frame " + std::to_string(latest) +
+                                " in channel \"" + name_ + "\" has size " +
+                                std::to_string(size) + " beyond capacity " +
+                                std::to_string(capacity_));
+    }
+    if (frame != latest) {
+      continue;
+    }
+
+    // The copy may race with the writer, in which case the sequence changed
+    // and we discard it
+    std::memcpy(data, slot_data_(slot), size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+      last_read_frame_ = latest;
+      return size;
+    }
+  }
+  return 0;
+}
+
+bool ShmChannel::update(Dictionary &dict) {
+  const size_t size = read(buffer_.data());
+  if (size == 0) {
+    return false;
+  }
+  dict.stream_update(buffer_.data(), size);
+  return true;
+}
+
+std::uint64_t ShmChannel::frame() const noexcept {
+  return header_->frame.load(std::memory_order_acquire);
+}
+
+size_t ShmChannel::slot_stride_(size_t capacity) noexcept {
+  return align_up(sizeof(Slot) + capacity);
+}
+
+size_t ShmChannel::mapped_size_(size_t capacity) noexcept {
+  return align_up(sizeof(Header)) + 2 * slot_stride_(capacity);
+}
+
+ShmChannel::Slot &ShmChannel::slot_(std::uint64_t frame) const noexcept {
+  char *slots = static_cast<char *>(mapping_) + align_up(sizeof(Header));
+  return *reinterpret_cast<Slot *>(slots +
+                                   (frame % 2) * slot_stride_(capacity_));
+}
+
+char *ShmChannel::slot_data_(Slot &slot) const noexcept {
+  return reinterpret_cast<char *>(&slot) + sizeof(Slot);
+}
+
+void ShmChannel::check_writer_() const {
+  if (!is_writer_) {
+    throw SystemError(__FILE__, __LINE__,
+                      "Channel \"" + name_ +
+                          "\" was opened as a reader and cannot be written to");
+  }
+}
+
+ShmChannel::Slot &ShmChannel::begin_write_() noexcept {
+  // Only this process writes, so that relaxed loads see our own stores
+  const std::uint64_t next =
+      header_->frame.load(std::memory_order_relaxed) + 1;
+  Slot &slot = slot_(next);
+  const std::uint64_t sequence =
+      slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.frame.store(next, std::memory_order_relaxed);
+  return slot;
+}
+
+void ShmChannel::end_write_(Slot &slot, size_t size) noexcept {
+  const std::uint64_t sequence =
+      slot.sequence.load(std::memory_order_relaxed);
+  slot.size.store(size, std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_release);
+  header_->frame.store(slot.frame.load(std::memory_order_relaxed),
+                       std::memory_order_release);
+}
+
+void ShmChannel::abort_write_(Slot &slot) noexcept {
+  // Readers check frame numbers, so that they skip this slot
+  const std::uint64_t sequence =
+      slot.sequence.load(std::memory_order_relaxed);
+  slot.frame.store(0, std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_release);
+}
+
+void ShmChannel::map_(int fd, size_t size, bool writable) {
+  const int protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+  void *mapping = ::mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+  const int error_number = errno;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw SystemError(__FILE__, __LINE__,
+                      "Cannot map shared memory \"" + name_ + "\"",
+                      error_number);
+  }
+  mapping_ = mapping;
+  mapped_bytes_ = size;
+  header_ = static_cast<Header *>(mapping);
+}
+
+}  // namespace palimpsest
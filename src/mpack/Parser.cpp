@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/mpack/Parser.h"
+
+#include <mpack.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace palimpsest::mpack {
+
+Parser::Parser(size_t nb_nodes) : pool_(std::max<size_t>(nb_nodes, 1)) {}
+
+Parser::~Parser() { destroy_tree_(); }
+
+mpack_node_t Parser::parse(const char *data, size_t size) {
+  for (;;) {
+    destroy_tree_();
+    mpack_tree_init_pool(&tree_, data, size, pool_.data(), pool_.size());
+    has_tree_ = true;
+    mpack_tree_parse(&tree_);
+
+    // Every node takes at least one byte, so a pool of size nodes is enough
+    if (mpack_tree_error(&tree_) != mpack_error_too_big ||
+        pool_.size() >= size) {
+      break;
+    }
+    pool_.resize(std::min(2 * pool_.size(), size));
+  }
+  return mpack_tree_root(&tree_);
+}
+
+mpack_error_t Parser::error() noexcept {
+  return has_tree_ ? mpack_tree_error(&tree_) : mpack_ok;
+}
+
+void Parser::destroy_tree_() noexcept {
+  if (has_tree_) {
+    mpack_tree_destroy(&tree_);
+    has_tree_ = false;
+  }
+}
+
+}  // namespace palimpsest::mpack
@@ -13,9 +13,15 @@
 
 #include <mpack.h>
 
+#include <cstring>
+#include <memory>
+#include <new>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "palimpsest/exceptions/PalimpsestError.h"
+
 #if not EIGEN_VERSION_AT_LEAST(3, 2, 90)
 namespace Eigen {
 using Index = Eigen::DenseIndex;
@@ -103,17 +109,156 @@ static void mpack_std_vector_writer_flush(mpack_writer_t *writer,
 
 namespace palimpsest::mpack {
 
-Writer::Writer(std::vector<char> &buffer) {
+Writer::Writer()
+    : owned_(new char[MPACK_BUFFER_SIZE]), owned_capacity_(MPACK_BUFFER_SIZE) {
+  init_();
+}
+
+Writer::Writer(std::vector<char> &buffer) : vector_(&buffer) {
   if (buffer.size() == 0) {
     buffer.resize(MPACK_BUFFER_SIZE);
   }
-  mpack_writer_init(&writer_, buffer.data(), buffer.size());
-  mpack_writer_set_context(&writer_, &buffer);  // used in flush function
-  mpack_writer_set_flush(&writer_, mpack_std_vector_writer_flush);
+  init_();
+}
+
+Writer::Writer(char *data, size_t capacity) {
+  fixed_.data = data;
+  fixed_.capacity = capacity;
+  init_();
 }
 
 Writer::~Writer() {}
 
+void Writer::init_() {
+  finished_ = false;
+  required_size_ = 0;
+  if (vector_ != nullptr) {
+    mpack_writer_init(&writer_, vector_->data(), vector_->size());
+    mpack_writer_set_context(&writer_, vector_);  // used in flush function
+    mpack_writer_set_flush(&writer_, mpack_std_vector_writer_flush);
+  } else if (owned_) {
+    mpack_writer_init(&writer_, owned_.get(), owned_capacity_);
+    mpack_writer_set_context(&writer_, this);  // used in flush function
+    mpack_writer_set_flush(&writer_, owned_buffer_flush_);
+  } else {
+    fixed_.size = 0;
+    fixed_.overflow = 0;
+    if (fixed_.capacity < sizeof(fixed_.scratch)) {
+      // MPack needs room for the largest tag after a flush: small messages
+      // are written to the scratch buffer, then copied to data if they fit
+      mpack_writer_init(&writer_, fixed_.scratch, sizeof(fixed_.scratch));
+    } else {
+      mpack_writer_init(&writer_, fixed_.data, fixed_.capacity);
+    }
+    mpack_writer_set_context(&writer_, &fixed_);  // used in flush function
+    mpack_writer_set_flush(&writer_, fixed_buffer_flush_);
+  }
+}
+
+void Writer::reset() {
+  if (!finished_) {
+    // Cancel the unfinished message: an error skips the teardown flush and
+    // the checks that all arrays and maps have been closed
+    mpack_writer_flag_error(&writer_, mpack_error_data);
+    mpack_writer_destroy(&writer_);
+  }
+  init_();
+}
+
+void Writer::owned_buffer_flush_(mpack_writer_t *writer, const char *data,
+                                 size_t count) {
+  auto &self = *static_cast<Writer *>(writer->context);
+
+  // Same cases as the flush function for std::vector
+  if (data == writer->buffer) {
+    if (mpack_writer_buffer_used(writer) == count) {
+      // teardown, do nothing
+      return;
+    }
+    // otherwise leave the data in the buffer and just grow
+    writer->current = writer->buffer + count;
+    count = 0;
+  }
+
+  const size_t used = mpack_writer_buffer_used(writer);
+  size_t new_size = mpack_writer_buffer_size(writer) * 2;
+  while (new_size < used + count) {
+    new_size *= 2;
+  }
+
+  // New memory is default-initialized, i.e. not zero-filled
+  std::unique_ptr<char[]> new_buffer(new (std::nothrow) char[new_size]);
+  if (new_buffer == nullptr) {
+    mpack_writer_flag_error(writer, mpack_error_memory);
+    return;
+  }
+  std::memcpy(new_buffer.get(), writer->buffer, used);
+  self.owned_ = std::move(new_buffer);
+  self.owned_capacity_ = new_size;
+  writer->buffer = self.owned_.get();
+  writer->current = writer->buffer + used;
+  writer->end = writer->buffer + new_size;
+
+  // append the extra data
+  if (count > 0) {
+    std::memcpy(writer->current, data, count);
+    writer->current += count;
+  }
+}
+
+void Writer::fixed_buffer_flush_(mpack_writer_t *writer, const char *data,
+                                 size_t count) {
+  auto &fixed = *static_cast<FixedBuffer *>(writer->context);
+  if (count == 0) {
+    return;
+  }
+  const bool in_scratch = (writer->buffer == fixed.scratch);
+
+  if (data == writer->buffer && mpack_writer_buffer_used(writer) == count) {
+    // teardown
+    if (!in_scratch) {
+      fixed.size = count;
+    } else if (fixed.capacity < sizeof(fixed.scratch) &&
+               fixed.overflow == 0 && count <= fixed.capacity) {
+      // small message written to the scratch buffer from the start
+      std::memcpy(fixed.data, data, count);
+      fixed.size = count;
+    } else {
+      fixed.overflow += count;
+    }
+    return;
+  }
+
+  // The message does not fit: keep what has been written to the caller's
+  // buffer, then count and discard the rest in the scratch buffer
+  if (data == writer->buffer && !in_scratch) {
+    fixed.size = count;
+  } else {
+    fixed.overflow += count;
+  }
+  writer->buffer = fixed.scratch;
+  writer->current = fixed.scratch;
+  writer->end = fixed.scratch + sizeof(fixed.scratch);
+}
+
+const char *Writer::data() const noexcept {
+  if (vector_ != nullptr) {
+    return vector_->data();
+  } else if (owned_) {
+    return owned_.get();
+  }
+  return fixed_.data;
+}
+
+size_t Writer::capacity() const noexcept {
+  if (vector_ != nullptr) {
+    return vector_->size();
+  } else if (owned_) {
+    return owned_capacity_;
+  }
+  return fixed_.capacity;
+}
+
 void Writer::write(bool b) { mpack_write_bool(&writer_, b); }
 
 void Writer::write(int8_t i) { mpack_write_i8(&writer_, i); }
@@ -140,58 +285,67 @@ void Writer::write(const std::string &s) {
   mpack_write_str(&writer_, s.c_str(), static_cast<uint32_t>(s.size()));
 }
 
-void Writer::write(const char *s) { mpack_write_cstr(&writer_, s); }
-
-namespace {
-
-template <typename T>
-inline void write_vector(mpack_writer_t *writer, const T &v) {
-  for (Eigen::Index i = 0; i < v.size(); ++i) {
-    mpack_write_double(writer, v(i));
-  }
+void Writer::write(std::string_view s) {
+  mpack_write_str(&writer_, s.data(), static_cast<uint32_t>(s.size()));
 }
 
-template <typename T>
-inline void write_matrix(mpack_writer_t *writer, const T &m) {
-  for (Eigen::Index i = 0; i < m.rows(); ++i) {
-    for (Eigen::Index j = 0; j < m.cols(); ++j) {
-      mpack_write_double(writer, m(i, j));
-    }
-  }
-}
+void Writer::write(const char *s) { mpack_write_cstr(&writer_, s); }
 
-}  // namespace
+void Writer::write_bytes(const char *data, size_t size) {
+  mpack_write_bytes(&writer_, data, size);
+}
 
 void Writer::write(const Eigen::Vector2d &v) {
+  if (array_encoding_ == ArrayEncoding::kBinary) {
+    write_binary(&writer_, v);
+    return;
+  }
   start_array(2);
-  write_vector(&writer_, v);
+  write_doubles(&writer_, v.data(), static_cast<size_t>(v.size()));
   finish_array();
 }
 
 void Writer::write(const Eigen::Vector3d &v) {
+  if (array_encoding_ == ArrayEncoding::kBinary) {
+    write_binary(&writer_, v);
+    return;
+  }
   start_array(3);
-  write_vector(&writer_, v);
+  write_doubles(&writer_, v.data(), static_cast<size_t>(v.size()));
   finish_array();
 }
 
 void Writer::write(const Eigen::VectorXd &v) {
+  if (array_encoding_ == ArrayEncoding::kBinary) {
+    write_binary(&writer_, v);
+    return;
+  }
   start_array(static_cast<size_t>(v.size()));
-  write_vector(&writer_, v);
+  write_doubles(&writer_, v.data(), static_cast<size_t>(v.size()));
   finish_array();
 }
 
 void Writer::write(const Eigen::Quaterniond &q) {
+  const double coeffs[4] = {q.w(), q.x(), q.y(), q.z()};
   start_array(4);
-  write(q.w());
-  write(q.x());
-  write(q.y());
-  write(q.z());
+  write_doubles(&writer_, coeffs, 4);
   finish_array();
 }
 
 void Writer::write(const Eigen::Matrix3d &m) {
+  if (array_encoding_ == ArrayEncoding::kBinary) {
+    write_binary(&writer_, m);
+    return;
+  }
   start_array(9);
-  write_matrix(&writer_, m);
+  const Eigen::Matrix3d transpose = m.transpose();  // row-major coefficients
+  write_doubles(&writer_, transpose.data(), 9);
+  finish_array();
+}
+
+void Writer::write(const std::vector<double> &v) {
+  start_array(v.size());
+  write_doubles(&writer_, v.data(), v.size());
   finish_array();
 }
 
@@ -208,11 +362,22 @@ void Writer::start_map(size_t s) {
 void Writer::finish_map() { mpack_finish_map(&writer_); }
 
 size_t Writer::finish() {
-  if (mpack_writer_destroy(&writer_) != mpack_ok) {
-    mpack_log("Failed to write to MessagePack");
-    return 0;
+  finished_ = true;
+  const mpack_error_t status = mpack_writer_destroy(&writer_);
+  if (status != mpack_ok) {
+    // Overflows of fixed-capacity buffers are counted without an error, so
+    // that any error here means the message is invalid, not just too long
+    throw exceptions::PalimpsestError(
+        __FILE__, __LINE__,
+        std::string("Failed to write to MessagePack: ") +
+            mpack_error_to_string(status));
+  }
+  if (vector_ == nullptr && !owned_) {
+    required_size_ = fixed_.size + fixed_.overflow;
+    return (fixed_.overflow == 0) ? fixed_.size : 0;
   }
-  return mpack_writer_buffer_used(&writer_);
+  required_size_ = mpack_writer_buffer_used(&writer_);
+  return required_size_;
 }
 
 }  // namespace palimpsest::mpack
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/mpack/read_doubles.h"
+
+#include <mpack.h>
+
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PALIMPSEST_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define PALIMPSEST_X86_KERNELS 0
+#endif
+
+namespace palimpsest::mpack {
+
+namespace {
+
+//! Size of a MessagePack float64: 0xcb tag followed by eight bytes.
+constexpr size_t kDoubleSize = 9;
+
+//! Kernel decoding consecutive MessagePack float64 values to doubles.
+using Kernel = bool (*)(double *, const char *, size_t);
+
+//! Kernel and its name.
+struct Dispatch {
+  //! Kernel function.
+  Kernel kernel;
+
+  //! Name of the kernel.
+  const char *name;
+};
+
+/*! Decode a MessagePack float64 to a double, without checking its tag.
+ *
+ * @param[in] in Nine bytes to read from.
+ * @return Decoded double.
+ */
+inline double decode_double(const char *in) {
+  uint64_t bits;
+  std::memcpy(&bits, in + 1, sizeof(bits));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  // already big-endian
+#elif defined(__GNUC__)
+  bits = __builtin_bswap64(bits);
+#else
+  bits = ((bits & 0x00000000000000ffull) << 56) |
+         ((bits & 0x000000000000ff00ull) << 40) |
+         ((bits & 0x0000000000ff0000ull) << 24) |
+         ((bits & 0x00000000ff000000ull) << 8) |
+         ((bits & 0x000000ff00000000ull) >> 8) |
+         ((bits & 0x0000ff0000000000ull) >> 24) |
+         ((bits & 0x00ff000000000000ull) >> 40) |
+         ((bits & 0xff00000000000000ull) >> 56);
+#endif
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+//! Decode values one at a time, returning whether all tags were 0xcb.
+bool decode_scalar(double *out, const char *in, size_t count) {
+  bool all_doubles = true;
+  for (size_t i = 0; i < count; ++i) {
+    all_doubles &= (in[kDoubleSize * i] == static_cast<char>(0xcb));
+    out[i] = decode_double(in + kDoubleSize * i);
+  }
+  return all_doubles;
+}
+
+#if PALIMPSEST_X86_KERNELS
+/*
+ * The vector kernels load sixteen bytes at the tag of each value, compare
+ * the first byte to 0xcb and shuffle the next eight bytes to a little-endian
+ * double. Loads read seven bytes past the value, so that the last value is
+ * decoded by the scalar kernel to stay within the input.
+ */
+
+//! Decode values with SSSE3 byte shuffles, one per value.
+__attribute__((target("ssse3"))) bool decode_ssse3(double *out,
+                                                   const char *in,
+                                                   size_t count) {
+  const __m128i shuffle = _mm_setr_epi8(8, 7, 6, 5, 4, 3, 2, 1,  //
+                                        -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m128i tags = _mm_set1_epi8(static_cast<char>(0xcb));
+  __m128i matches = _mm_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 1 < count; ++i) {
+    const char *src = in + kDoubleSize * i;
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    matches = _mm_and_si128(matches, _mm_cmpeq_epi8(bytes, tags));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + i),
+                     _mm_shuffle_epi8(bytes, shuffle));
+  }
+  const bool all_doubles = (_mm_movemask_epi8(matches) & 0x1);
+  return decode_scalar(out + i, in + kDoubleSize * i, count - i) &&
+         all_doubles;
+}
+
+//! Decode values with AVX2 byte shuffles, one per two values.
+__attribute__((target("avx2"))) bool decode_avx2(double *out, const char *in,
+                                                 size_t count) {
+  const __m256i shuffle = _mm256_setr_epi8(
+      8, 7, 6, 5, 4, 3, 2, 1, -1, -1, -1, -1, -1, -1, -1, -1,  //
+      8, 7, 6, 5, 4, 3, 2, 1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i tags = _mm256_set1_epi8(static_cast<char>(0xcb));
+  __m256i matches = _mm256_set1_epi8(-1);
+  size_t i = 0;
+  for (; i + 4 < count; i += 4) {
+    // Values (i, i + 1) and (i + 2, i + 3) in the two 128-bit lanes of
+    // first and second respectively
+    const char *src = in + kDoubleSize * i;
+    __m256i first = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(src))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + kDoubleSize)),
+        1);
+    __m256i second = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(src + 2 * kDoubleSize))),
+        _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(src + 3 * kDoubleSize)),
+        1);
+    matches = _mm256_and_si256(
+        matches, _mm256_and_si256(_mm256_cmpeq_epi8(first, tags),
+                                  _mm256_cmpeq_epi8(second, tags)));
+    first = _mm256_shuffle_epi8(first, shuffle);
+    second = _mm256_shuffle_epi8(second, shuffle);
+
+    // Interleave to (i, i + 2, i + 1, i + 3) then reorder
+    const __m256i values = _mm256_permute4x64_epi64(
+        _mm256_unpacklo_epi64(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), values);
+  }
+  const bool all_doubles =
+      ((_mm256_movemask_epi8(matches) & 0x10001) == 0x10001);
+  return decode_ssse3(out + i, in + kDoubleSize * i, count - i) &&
+         all_doubles;
+}
+#endif  // PALIMPSEST_X86_KERNELS
+
+//! Select the fastest kernel the CPU supports.
+Dispatch select_kernel() noexcept {
+#if PALIMPSEST_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {&decode_avx2, "avx2"};
+  } else if (__builtin_cpu_supports("ssse3")) {
+    return {&decode_ssse3, "ssse3"};
+  }
+#endif
+  return {&decode_scalar, "scalar"};
+}
+
+//! Kernel selected on first use.
+const Dispatch &dispatch() noexcept {
+  static const Dispatch selected = select_kernel();
+  return selected;
+}
+
+}  // namespace
+
+bool expect_doubles(mpack_reader_t *reader, double *values, size_t count) {
+#if MPACK_READ_TRACKING
+  return false;
+#else
+  const char *data = nullptr;
+  if (mpack_reader_error(reader) != mpack_ok ||
+      mpack_reader_remaining(reader, &data) < kDoubleSize * count ||
+      !dispatch().kernel(values, data, count)) {
+    return false;
+  }
+  mpack_read_bytes_inplace(reader, kDoubleSize * count);
+  return true;
+#endif
+}
+
+const char *expect_doubles_kernel() noexcept { return dispatch().name; }
+
+}  // namespace palimpsest::mpack
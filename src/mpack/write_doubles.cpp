@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/mpack/write_doubles.h"
+
+#include <mpack.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PALIMPSEST_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define PALIMPSEST_X86_KERNELS 0
+#endif
+
+namespace palimpsest::mpack {
+
+namespace {
+
+//! Size of a MessagePack float64: 0xcb tag followed by eight bytes.
+constexpr size_t kDoubleSize = 9;
+
+//! Number of doubles encoded at once when the writer buffer is full.
+constexpr size_t kChunkSize = 64;
+
+//! Kernel encoding doubles to consecutive MessagePack float64 values.
+using Kernel = void (*)(char *, const double *, size_t);
+
+//! Kernel and its name.
+struct Dispatch {
+  //! Kernel function.
+  Kernel kernel;
+
+  //! Name of the kernel.
+  const char *name;
+};
+
+/*! Encode a double to a MessagePack float64.
+ *
+ * @param[out] out Nine bytes to write to.
+ * @param[in] value Double to encode.
+ */
+inline void encode_double(char *out, double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  // already big-endian
+#elif defined(__GNUC__)
+  bits = __builtin_bswap64(bits);
+#else
+  bits = ((bits & 0x00000000000000ffull) << 56) |
+         ((bits & 0x000000000000ff00ull) << 40) |
+         ((bits & 0x0000000000ff0000ull) << 24) |
+         ((bits & 0x00000000ff000000ull) << 8) |
+         ((bits & 0x000000ff00000000ull) >> 8) |
+         ((bits & 0x0000ff0000000000ull) >> 24) |
+         ((bits & 0x00ff000000000000ull) >> 40) |
+         ((bits & 0xff00000000000000ull) >> 56);
+#endif
+  out[0] = static_cast<char>(0xcb);
+  std::memcpy(out + 1, &bits, sizeof(bits));
+}
+
+//! Encode doubles one at a time.
+void encode_scalar(char *out, const double *values, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    encode_double(out + kDoubleSize * i, values[i]);
+  }
+}
+
+#if PALIMPSEST_X86_KERNELS
+/*
+ * The vector kernels load two consecutive doubles, then shuffle them to
+ * [0xcb, first double swapped, 0xcb, six bytes of the second double swapped]
+ * and store these sixteen bytes at the position of the first double. Every
+ * byte stored is final, so that stores of consecutive doubles can overlap.
+ * The last double, which has no successor to load, is encoded by the scalar
+ * kernel so that nothing is written past the end of the output.
+ */
+
+//! Encode doubles with SSSE3 byte shuffles, one per double.
+__attribute__((target("ssse3"))) void encode_ssse3(char *out,
+                                                   const double *values,
+                                                   size_t count) {
+  const __m128i shuffle = _mm_setr_epi8(-1, 7, 6, 5, 4, 3, 2, 1, 0,  //
+                                        -1, 15, 14, 13, 12, 11, 10);
+  const __m128i tags = _mm_setr_epi8(static_cast<char>(0xcb), 0, 0, 0, 0, 0,
+                                     0, 0, 0, static_cast<char>(0xcb), 0, 0,
+                                     0, 0, 0, 0);
+  size_t i = 0;
+  for (; i + 1 < count; ++i) {
+    __m128i pair =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+    pair = _mm_or_si128(_mm_shuffle_epi8(pair, shuffle), tags);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + kDoubleSize * i),
+                     pair);
+  }
+  encode_scalar(out + kDoubleSize * i, values + i, count - i);
+}
+
+//! Encode doubles with AVX2 byte shuffles, one per two doubles.
+__attribute__((target("avx2"))) void encode_avx2(char *out,
+                                                 const double *values,
+                                                 size_t count) {
+  const __m256i shuffle = _mm256_setr_epi8(
+      -1, 7, 6, 5, 4, 3, 2, 1, 0, -1, 15, 14, 13, 12, 11, 10,  //
+      -1, 7, 6, 5, 4, 3, 2, 1, 0, -1, 15, 14, 13, 12, 11, 10);
+  const char tag = static_cast<char>(0xcb);
+  const __m256i tags = _mm256_setr_epi8(
+      tag, 0, 0, 0, 0, 0, 0, 0, 0, tag, 0, 0, 0, 0, 0, 0,  //
+      tag, 0, 0, 0, 0, 0, 0, 0, 0, tag, 0, 0, 0, 0, 0, 0);
+  size_t i = 0;
+  for (; i + 4 < count; i += 4) {
+    // Pairs (i, i + 1) and (i + 2, i + 3), then (i + 1, i + 2) and (i + 3,
+    // i + 4), in the two 128-bit lanes of even and odd respectively
+    __m256i even =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+    __m256i odd =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i + 1));
+    even = _mm256_or_si256(_mm256_shuffle_epi8(even, shuffle), tags);
+    odd = _mm256_or_si256(_mm256_shuffle_epi8(odd, shuffle), tags);
+    char *dest = out + kDoubleSize * i;
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest),
+                     _mm256_castsi256_si128(even));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + kDoubleSize),
+                     _mm256_castsi256_si128(odd));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 2 * kDoubleSize),
+                     _mm256_extracti128_si256(even, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + 3 * kDoubleSize),
+                     _mm256_extracti128_si256(odd, 1));
+  }
+  encode_ssse3(out + kDoubleSize * i, values + i, count - i);
+}
+#endif  // PALIMPSEST_X86_KERNELS
+
+//! Select the fastest kernel the CPU supports.
+Dispatch select_kernel() noexcept {
+#if PALIMPSEST_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return {&encode_avx2, "avx2"};
+  } else if (__builtin_cpu_supports("ssse3")) {
+    return {&encode_ssse3, "ssse3"};
+  }
+#endif
+  return {&encode_scalar, "scalar"};
+}
+
+//! Kernel selected on first use.
+const Dispatch &dispatch() noexcept {
+  static const Dispatch selected = select_kernel();
+  return selected;
+}
+
+}  // namespace
+
+void write_doubles(mpack_writer_t *writer, const double *values,
+                   size_t count) {
+#if MPACK_WRITE_TRACKING
+  for (size_t i = 0; i < count; ++i) {
+    mpack_write_double(writer, values[i]);
+  }
+#else
+  const Kernel kernel = dispatch().kernel;
+  while (count > 0 && mpack_writer_error(writer) == mpack_ok) {
+    const size_t left = mpack_writer_buffer_left(writer) / kDoubleSize;
+    size_t nb_values = 0;
+    if (left > 0) {
+      // Encode directly into the buffer of the writer
+      nb_values = std::min(count, left);
+      kernel(writer->current, values, nb_values);
+      writer->current += kDoubleSize * nb_values;
+    } else {
+      // Let MPack flush the buffer while writing a chunk
+      char chunk[kDoubleSize * kChunkSize];
+      nb_values = std::min(count, kChunkSize);
+      kernel(chunk, values, nb_values);
+      mpack_write_bytes(writer, chunk, kDoubleSize * nb_values);
+    }
+    values += nb_values;
+    count -= nb_values;
+  }
+#endif
+}
+
+const char *write_doubles_kernel() noexcept { return dispatch().name; }
+
+}  // namespace palimpsest::mpack
@@ -14,14 +14,19 @@
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "cppcodec/base64_rfc4648.hpp"
 #include "palimpsest/Dictionary.h"
+#include "palimpsest/exceptions/FrozenError.h"
 #include "palimpsest/exceptions/KeyError.h"
+#include "palimpsest/exceptions/PalimpsestError.h"
 #include "palimpsest/exceptions/TypeError.h"
 #include "palimpsest/mpack/Writer.h"
 
@@ -79,9 +84,39 @@ void write(std::ostream &stream, const Serializable &s) {
 
 }  // namespace palimpsest::json
 
+/*! Memory resource that counts allocations forwarded to its upstream.
+ */
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  //! Number of allocations not yet deallocated.
+  int live_allocations = 0;
+
+  //! Total number of allocations.
+  int total_allocations = 0;
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    ++live_allocations;
+    ++total_allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    --live_allocations;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
 namespace palimpsest {
 
+using exceptions::FrozenError;
 using exceptions::KeyError;
+using exceptions::PalimpsestError;
 using exceptions::TypeError;
 
 class DictionaryTest : public ::testing::Test {
@@ -951,4 +986,1063 @@ TEST(Dictionary, SerializeVectorOfVectorXd) {
   }
 }
 
+TEST(Dictionary, MemoryResource) {
+  CountingResource resource;
+  {
+    Dictionary dict(&resource);
+    ASSERT_EQ(dict.memory_resource(), &resource);
+    dict("temperature") = 28.0;
+    dict("bodies")("plane")("position") = Eigen::Vector3d{0.0, 0.0, 100.0};
+    const int nb_allocations = resource.live_allocations;
+    dict("bodies")("plane").insert<std::string>("name", "plane");
+    ASSERT_EQ(dict("bodies")("plane").memory_resource(), &resource);
+    ASSERT_GT(resource.live_allocations, nb_allocations);
+    dict("bodies")("plane").insert<Eigen::Quaterniond>("orientation", 1., 0.,
+                                                       0., 0.);
+
+    // Eigen alignment is preserved
+    const auto &orientation =
+        dict("bodies")("plane")("orientation").as<Eigen::Quaterniond>();
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(&orientation) % alignof(orientation),
+              0u);
+
+    // Removing a value frees its buffer
+    const auto &plane = dict("bodies")("plane");
+    Dictionary empty_plane(&resource);
+    dict("bodies")("plane") = std::move(empty_plane);
+    ASSERT_LT(resource.live_allocations, nb_allocations);
+    ASSERT_TRUE(plane.is_empty());
+  }
+  ASSERT_EQ(resource.live_allocations, 0);
+}
+
+TEST(Dictionary, ClearKeepsBuffers) {
+  CountingResource resource;
+  Dictionary dict(&resource);
+  for (int cycle = 0; cycle < 3; ++cycle) {
+    const int nb_allocations = resource.total_allocations;
+    for (int i = 0; i < 100; ++i) {
+      dict(std::to_string(i));  // empty map, stored in the slabs of dict
+    }
+    if (cycle > 0) {
+      ASSERT_EQ(resource.total_allocations, nb_allocations);
+    }
+    dict.clear();
+  }
+}
+
+TEST(Dictionary, MonotonicArena) {
+  std::pmr::monotonic_buffer_resource arena(4096);
+  Dictionary dict(&arena);
+  dict("foo") = 12;
+  dict("bar")("position") = Eigen::Vector3d{1.0, 2.0, 3.0};
+  dict("bar")("name") = std::string("arena");
+
+  std::vector<char> buffer;
+  size_t size = dict.serialize(buffer);
+  Dictionary checker;
+  checker.update(buffer.data(), size);
+  ASSERT_EQ(checker("foo").as<unsigned>(), 12u);  // deserialized as unsigned
+  ASSERT_TRUE(checker("bar")("position")
+                  .as<Eigen::Vector3d>()
+                  .isApprox(Eigen::Vector3d{1.0, 2.0, 3.0}));
+  ASSERT_EQ(checker("bar")("name").as<std::string>(), "arena");
+  dict.clear();
+  ASSERT_TRUE(dict.is_empty());
+}
+
+TEST(Dictionary, MoveKeepsMemoryResource) {
+  CountingResource resource;
+  Dictionary source(&resource);
+  source("answer") = 42;
+  const int nb_allocations = resource.live_allocations;
+  Dictionary target = std::move(source);
+  ASSERT_EQ(target.memory_resource(), &resource);
+  ASSERT_EQ(target("answer").as<int>(), 42);
+  ASSERT_EQ(resource.live_allocations, nb_allocations);
+  target("name") = std::string("answer");
+  ASSERT_GT(resource.live_allocations, nb_allocations);
+}
+
+TEST(Dictionary, ManyKeys) {
+  Dictionary dict;
+  std::vector<double *> references;
+  for (int i = 0; i < 1000; ++i) {
+    references.push_back(&dict.insert<double>(std::to_string(i), i));
+  }
+  ASSERT_EQ(dict.size(), 1000);
+  ASSERT_EQ(dict.keys().size(), 1000);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(dict.has(std::to_string(i)));
+    ASSERT_DOUBLE_EQ(dict.get<double>(std::to_string(i)), i);
+    ASSERT_EQ(&dict.get<double>(std::to_string(i)), references[i]);
+  }
+  ASSERT_FALSE(dict.has("1000"));
+
+  // Remove every other key
+  for (int i = 0; i < 1000; i += 2) {
+    dict.remove(std::to_string(i));
+  }
+  ASSERT_EQ(dict.size(), 500);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(dict.has(std::to_string(i)), i % 2 == 1);
+  }
+  for (int i = 1; i < 1000; i += 2) {
+    ASSERT_EQ(&dict.get<double>(std::to_string(i)), references[i]);
+  }
+
+  // Insert again
+  for (int i = 0; i < 1000; i += 2) {
+    dict(std::to_string(i)) = -i;
+  }
+  ASSERT_EQ(dict.size(), 1000);
+  for (int i = 0; i < 1000; i += 2) {
+    ASSERT_EQ(dict(std::to_string(i)).as<int>(), -i);
+  }
+}
+
+TEST(Dictionary, CompactKeysAfterSwap) {
+  Dictionary dict;
+  dict("a") = 1;
+  dict("BBBBBBBBBB") = 2;
+  dict("cccc") = 3;
+
+  // Erasing moves the last entry first, then compaction moves its key
+  dict.remove("a");
+  dict(std::string(20, 'D')) = 4;
+  dict.remove(std::string(20, 'D'));
+  ASSERT_EQ(dict.size(), 2);
+  ASSERT_TRUE(dict.has("BBBBBBBBBB"));
+  ASSERT_TRUE(dict.has("cccc"));
+  ASSERT_EQ(dict("BBBBBBBBBB").as<int>(), 2);
+  ASSERT_EQ(dict("cccc").as<int>(), 3);
+  std::vector<std::string> keys = dict.keys();
+  std::sort(keys.begin(), keys.end());
+  ASSERT_EQ(keys, (std::vector<std::string>{"BBBBBBBBBB", "cccc"}));
+}
+
+TEST(Dictionary, StringViewKeys) {
+  const std::string path = "foo/bar";
+  const std::string_view foo = std::string_view(path).substr(0, 3);
+  const std::string_view bar = std::string_view(path).substr(4);
+
+  Dictionary dict;
+  dict(foo)(bar) = 42.0;
+  ASSERT_TRUE(dict.has(foo));
+  ASSERT_FALSE(dict.has(path));
+  ASSERT_TRUE(dict(foo).has("bar"));
+  ASSERT_DOUBLE_EQ(dict(foo).get<double>(bar), 42.0);
+  ASSERT_DOUBLE_EQ(dict("foo").get<double>(std::string("bar")), 42.0);
+  ASSERT_DOUBLE_EQ(dict(foo).get<double>(std::string_view("baz"), 12.0),
+                   12.0);
+
+  const Dictionary &const_dict = dict;
+  ASSERT_DOUBLE_EQ(const_dict(foo).get<double>(bar), 42.0);
+  ASSERT_THROW(const_dict(bar), KeyError);
+
+  dict(foo).remove(bar);
+  ASSERT_TRUE(dict(foo).is_empty());
+}
+
+TEST(Dictionary, PrecomputedKeys) {
+  using namespace palimpsest::literals;  // NOLINT(build/namespaces)
+  constexpr auto kImu = "imu"_key;
+  constexpr auto kOrientation = "orientation"_key;
+  static_assert(kImu.hash() == Dictionary::Key("imu").hash());
+  static_assert(""_key.hash() == 14695981039346656037ull);
+  static_assert("a"_key.hash() == 0xaf63dc4c8601ec8cull);
+
+  Dictionary dict;
+  dict("observation")(kImu)(kOrientation) = Eigen::Quaterniond::Identity();
+  ASSERT_TRUE(dict("observation").has(kImu));
+  ASSERT_FALSE(dict("observation").has("orientation"_key));
+  ASSERT_TRUE(dict("observation")("imu").has(kOrientation));
+  ASSERT_EQ(&dict("observation")(kImu), &dict("observation")("imu"));
+
+  const Dictionary &imu = dict("observation")(kImu);
+  ASSERT_TRUE(imu.get<Eigen::Quaterniond>(kOrientation).isApprox(
+      Eigen::Quaterniond::Identity()));
+  ASSERT_EQ(&imu.get<Eigen::Quaterniond>(kOrientation),
+            &imu.get<Eigen::Quaterniond>("orientation"));
+  ASSERT_DOUBLE_EQ(imu.get<double>("temperature"_key, 42.0), 42.0);
+  ASSERT_THROW(imu.get<double>(kOrientation), TypeError);
+  ASSERT_THROW(imu("gyro"_key), KeyError);
+  ASSERT_THROW(dict.get<double>(kImu), KeyError);
+
+  // Keys built at runtime hash the same way
+  const std::string name = "orientation";
+  ASSERT_EQ(Dictionary::Key(name).hash(), kOrientation.hash());
+}
+
+TEST(Dictionary, ResolveHandle) {
+  Dictionary dict;
+  dict("bodies")("plane")("position") = Eigen::Vector3d{1.0, 2.0, 3.0};
+  dict("bodies")("plane")("name") = std::string("plane");
+
+  auto position = dict.resolve<Eigen::Vector3d>("bodies/plane/position");
+  ASSERT_EQ(position.path(), "bodies/plane/position");
+  ASSERT_TRUE(position.is_valid());
+  ASSERT_DOUBLE_EQ(position->z(), 3.0);
+  position->z() = 42.0;
+  const auto &plane = dict("bodies")("plane");
+  ASSERT_DOUBLE_EQ(plane("position").as<Eigen::Vector3d>().z(), 42.0);
+
+  // Assigning in place keeps the handle valid
+  dict("bodies")("plane")("position") = Eigen::Vector3d{4.0, 5.0, 6.0};
+  ASSERT_TRUE(position.is_valid());
+  ASSERT_DOUBLE_EQ((*position).x(), 4.0);
+
+  // Structural changes along the path invalidate the handle
+  dict("bodies")("truck")("position") = Eigen::Vector3d{0.0, 0.0, 0.0};
+  ASSERT_FALSE(position.is_valid());
+  ASSERT_DOUBLE_EQ(position->y(), 5.0);
+  ASSERT_TRUE(position.is_valid());
+
+  // Replaced values are resolved again
+  dict("bodies")("plane").remove("position");
+  ASSERT_FALSE(position.is_valid());
+  ASSERT_THROW(position.get(), KeyError);
+  dict("bodies")("plane")("position") = Eigen::Vector3d{7.0, 8.0, 9.0};
+  ASSERT_DOUBLE_EQ(position->z(), 9.0);
+  ASSERT_EQ(&position.get(),
+            &dict("bodies")("plane")("position").as<Eigen::Vector3d>());
+
+  Dictionary other_plane;
+  other_plane("position") = Eigen::Vector3d{-1.0, -2.0, -3.0};
+  dict("bodies")("plane") = std::move(other_plane);
+  ASSERT_FALSE(position.is_valid());
+  ASSERT_DOUBLE_EQ(position->x(), -1.0);
+
+  dict("bodies")("plane").clear();
+  ASSERT_FALSE(position.is_valid());
+  ASSERT_THROW(position.get(), KeyError);
+}
+
+TEST(Dictionary, ResolveErrors) {
+  Dictionary dict;
+  dict("foo")("bar") = 12.0;
+  ASSERT_THROW(dict.resolve<double>("foo/baz"), KeyError);
+  ASSERT_THROW(dict.resolve<double>("foo/bar/baz"), TypeError);
+  ASSERT_THROW(dict.resolve<int>("foo/bar"), TypeError);
+  ASSERT_THROW(dict.resolve<double>("foo"), TypeError);
+  ASSERT_NO_THROW(dict.resolve<double>("foo/bar"));
+
+  const Dictionary &const_dict = dict;
+  auto bar = const_dict.resolve<double>("foo/bar");
+  static_assert(std::is_same_v<decltype(bar.get()), const double &>);
+  ASSERT_DOUBLE_EQ(*bar, 12.0);
+}
+
+TEST(Dictionary, TypeTags) {
+  using internal::type_tag_v;
+  static_assert(type_tag_v<double> != type_tag_v<float>);
+  static_assert(type_tag_v<int> != type_tag_v<unsigned>);
+  static_assert(type_tag_v<Eigen::Vector3d> != type_tag_v<Eigen::Vector2d>);
+  static_assert(type_tag_v<const double> == type_tag_v<double>);
+
+  Dictionary dict;
+  dict("foo") = 12.0;
+  ASSERT_DOUBLE_EQ(dict("foo").as<const double>(), 12.0);
+  ASSERT_THROW(dict("foo").as<float>(), TypeError);
+}
+
+TEST(Dictionary, InlineValues) {
+  const auto is_stored_inline = [](const Dictionary &child, const void *value) {
+    const auto *begin = reinterpret_cast<const char *>(&child);
+    const auto *object = reinterpret_cast<const char *>(value);
+    return begin <= object && object < begin + sizeof(Dictionary);
+  };
+
+  CountingResource resource;
+  Dictionary dict(&resource);
+  auto &plane = dict("bodies")("plane");
+  plane("mass") = 1000.0;
+  plane("position") = Eigen::Vector3d{1.0, 2.0, 3.0};
+  plane.insert<Eigen::Quaterniond>("orientation", 1.0, 0.0, 0.0, 0.0);
+  plane.insert<bool>("flying", true);
+  plane.insert<int32_t>("passengers", 120);
+
+  // Small trivially relocatable values are stored inline
+  ASSERT_TRUE(is_stored_inline(plane("mass"), &plane.get<double>("mass")));
+  ASSERT_TRUE(is_stored_inline(plane("position"),
+                               &plane.get<Eigen::Vector3d>("position")));
+  ASSERT_TRUE(is_stored_inline(plane("flying"), &plane.get<bool>("flying")));
+  ASSERT_TRUE(is_stored_inline(plane("passengers"),
+                               &plane.get<int32_t>("passengers")));
+  const auto &orientation = plane.get<Eigen::Quaterniond>("orientation");
+  ASSERT_TRUE(is_stored_inline(plane("orientation"), &orientation));
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(&orientation) % alignof(orientation),
+            0u);
+
+  // Large or dynamic values are allocated from the memory resource
+  const int nb_allocations = resource.live_allocations;
+  plane("name") = std::string("glider");
+  plane("trajectory") = Eigen::VectorXd::Zero(12).eval();
+  ASSERT_FALSE(
+      is_stored_inline(plane("name"), &plane.get<std::string>("name")));
+  ASSERT_FALSE(is_stored_inline(plane("trajectory"),
+                                &plane.get<Eigen::VectorXd>("trajectory")));
+  ASSERT_GE(resource.live_allocations, nb_allocations + 2);
+
+  // Moving dictionaries relocates inline values
+  Dictionary moved = std::move(plane);
+  ASSERT_DOUBLE_EQ(moved("mass").as<double>(), 1000.0);
+  ASSERT_TRUE(moved("position").as<Eigen::Vector3d>().isApprox(
+      Eigen::Vector3d{1.0, 2.0, 3.0}));
+  ASSERT_TRUE(moved("orientation").as<Eigen::Quaterniond>().isApprox(
+      Eigen::Quaterniond::Identity()));
+  ASSERT_EQ(moved("passengers").as<int32_t>(), 120);
+  ASSERT_EQ(moved("name").as<std::string>(), "glider");
+
+  Dictionary number;
+  number = 42.0;
+  Dictionary other_number = std::move(number);
+  ASSERT_DOUBLE_EQ(other_number.as<double>(), 42.0);
+  ASSERT_TRUE(is_stored_inline(other_number, &other_number.as<double>()));
+  ASSERT_FALSE(number.is_value());
+}
+
+TEST(Dictionary, Freeze) {
+  CountingResource resource;
+  Dictionary dict(&resource);
+  dict("name") = std::string("world");
+  dict("temperature") = 28.0;
+  for (int i = 0; i < 12; ++i) {
+    auto &body = dict("bodies")("body_" + std::to_string(i));
+    body("position") = Eigen::Vector3d{1.0 * i, 0.0, 0.0};
+    body("orientation") = Eigen::Quaterniond::Identity();
+    body("trajectory") = Eigen::VectorXd::Constant(5, i).eval();
+  }
+  auto position = dict.resolve<Eigen::Vector3d>("bodies/body_3/position");
+  std::vector<char> buffer;
+  const size_t size = dict.serialize(buffer);
+  const std::string before(buffer.data(), size);
+
+  const int nb_allocations = resource.total_allocations;
+  dict.freeze();
+  ASSERT_EQ(resource.total_allocations, nb_allocations + 1);  // one block
+  ASSERT_TRUE(dict.is_frozen());
+  ASSERT_TRUE(dict("bodies")("body_7").is_frozen());
+  ASSERT_DOUBLE_EQ(position->x(), 3.0);
+
+  // Freezing keeps contents and serialization unchanged
+  ASSERT_EQ(dict("name").as<std::string>(), "world");
+  ASSERT_DOUBLE_EQ(dict("temperature").as<double>(), 28.0);
+  ASSERT_EQ(dict("bodies").size(), 12);
+  ASSERT_TRUE(dict("bodies")("body_11")("trajectory")
+                  .as<Eigen::VectorXd>()
+                  .isApprox(Eigen::VectorXd::Constant(5, 11.0)));
+  const auto &orientation =
+      dict("bodies")("body_5")("orientation").as<Eigen::Quaterniond>();
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(&orientation) % alignof(orientation),
+            0u);
+  ASSERT_EQ(dict.serialize(buffer), size);
+  ASSERT_EQ(std::string(buffer.data(), size), before);
+
+  // Values can be updated but the structure cannot
+  auto &temperature = dict("temperature").as<double>();
+  dict("temperature") = 30.0;
+  ASSERT_DOUBLE_EQ(temperature, 30.0);
+  Dictionary source;
+  source("temperature") = 32.0;
+  source("bodies")("body_1")("position") = Eigen::Vector3d{4.0, 5.0, 6.0};
+  source.serialize(buffer);
+  dict.update(buffer.data(), buffer.size());
+  ASSERT_DOUBLE_EQ(temperature, 32.0);
+  ASSERT_DOUBLE_EQ(dict("bodies")("body_1")("position")
+                       .as<Eigen::Vector3d>()
+                       .z(),
+                   6.0);
+  ASSERT_THROW(dict("pressure"), FrozenError);
+  ASSERT_THROW(dict("bodies").insert<double>("mass", 1.0), FrozenError);
+  ASSERT_THROW(dict("bodies").remove("body_0"), FrozenError);
+  ASSERT_THROW(dict("bodies")("body_0").clear(), FrozenError);
+  ASSERT_THROW(dict("bodies")("body_0") = 12.0, FrozenError);
+  ASSERT_THROW(dict("bodies")("body_0") = Dictionary(), FrozenError);
+  ASSERT_THROW(Dictionary(std::move(dict("bodies"))), FrozenError);
+  ASSERT_THROW(dict("bodies").thaw(), FrozenError);
+  ASSERT_EQ(dict("bodies").size(), 12);
+
+  // Thawing restores regular allocations
+  dict.thaw();
+  ASSERT_FALSE(dict.is_frozen());
+  ASSERT_FALSE(dict("bodies")("body_7").is_frozen());
+  ASSERT_DOUBLE_EQ(dict("temperature").as<double>(), 32.0);
+  ASSERT_DOUBLE_EQ(position->x(), 3.0);
+  dict("pressure") = 1.0;
+  dict("bodies").remove("body_0");
+  ASSERT_EQ(dict("bodies").size(), 11);
+  dict = Dictionary();
+  ASSERT_EQ(resource.live_allocations, 0);
+}
+
+TEST(Dictionary, FreezeMovesWithRoot) {
+  Dictionary dict;
+  dict("foo")("bar") = 12.0;
+  dict("foo")("baz") = std::string("baz");
+  dict.freeze();
+  const double &bar = dict("foo")("bar");
+
+  Dictionary other = std::move(dict);
+  ASSERT_TRUE(other.is_frozen());
+  ASSERT_FALSE(dict.is_frozen());
+  ASSERT_EQ(&bar, &other("foo")("bar").as<double>());
+  ASSERT_EQ(other("foo")("baz").as<std::string>(), "baz");
+  other.thaw();
+  other("foo")("qux") = 1.0;
+  ASSERT_EQ(other("foo").size(), 3);
+}
+
+TEST(Dictionary, SerializationPlanIsByteIdentical) {
+  const std::string long_key(40, 'k');  // encoded as str8
+  Dictionary dict;
+  for (int i = 0; i < 16; ++i) {  // map16
+    dict("numbers")(std::to_string(i)) = i;
+  }
+  dict(long_key) = std::string("value");
+  dict("empty");
+  dict("empty").clear();
+
+  auto expected_bytes = [&long_key](int nb_numbers, bool with_empty) {
+    std::vector<char> buffer;
+    mpack::Writer writer(buffer);
+    writer.start_map(with_empty ? 3 : 2);
+    writer.write("numbers");
+    writer.start_map(nb_numbers);
+    for (int i = 0; i < nb_numbers; ++i) {
+      writer.write(std::to_string(i));
+      writer.write(i);
+    }
+    writer.finish_map();
+    writer.write(long_key);
+    writer.write(std::string("value"));
+    if (with_empty) {
+      writer.write("empty");
+      writer.start_map(0);
+      writer.finish_map();
+    }
+    writer.finish_map();
+    size_t size = writer.finish();
+    return std::vector<char>(buffer.begin(), buffer.begin() + size);
+  };
+  auto serialized_bytes = [&dict]() {
+    std::vector<char> buffer;
+    size_t size = dict.serialize(buffer);
+    return std::vector<char>(buffer.begin(), buffer.begin() + size);
+  };
+
+  ASSERT_EQ(serialized_bytes(), expected_bytes(16, true));
+  ASSERT_EQ(serialized_bytes(), expected_bytes(16, true));  // cached plan
+
+  // Updating values keeps the plan and writes the new values
+  dict("numbers")("3") = 3;
+  ASSERT_EQ(serialized_bytes(), expected_bytes(16, true));
+
+  // Structural changes recompile the plan
+  dict("numbers")("16") = 16;
+  ASSERT_EQ(serialized_bytes(), expected_bytes(17, true));
+  dict("numbers").remove("16");
+  dict.remove("empty");
+  ASSERT_EQ(serialized_bytes(), expected_bytes(16, false));
+  dict("empty");
+  dict("empty").clear();
+  dict.freeze();
+  ASSERT_EQ(serialized_bytes(), expected_bytes(16, true));
+
+  // Moving the tree serializes the same bytes from the new root
+  Dictionary other = std::move(dict);
+  std::vector<char> buffer;
+  size_t size = other.serialize(buffer);
+  ASSERT_EQ(std::vector<char>(buffer.begin(), buffer.begin() + size),
+            expected_bytes(16, true));
+}
+
+TEST(Dictionary, SerializationPlanFollowsValueChanges) {
+  Dictionary dict;
+  dict("a") = 1;
+  dict("b")("c") = 2.0;
+  std::vector<char> buffer;
+  dict.serialize(buffer);
+
+  dict("b")("c") = 3.0;
+  dict.remove("a");
+  dict("a")("d") = 4;  // same key, now a map
+  size_t size = dict.serialize(buffer);
+  Dictionary deserialized;
+  deserialized.update(buffer.data(), size);
+  ASSERT_EQ(deserialized("a")("d").as<unsigned>(), 4);
+  ASSERT_DOUBLE_EQ(deserialized("b")("c").as<double>(), 3.0);
+}
+
+TEST(Dictionary, StreamUpdate) {
+  Dictionary source;
+  source("flag") = true;
+  source("count") = 42u;
+  source("offset") = -3;
+  source("name") = std::string("upkie");
+  source("servo")("left")("position") = 1.5;
+  source("imu")("orientation") = Eigen::Quaterniond(0.0, 1.0, 0.0, 0.0);
+  source("imu")("acceleration") = Eigen::Vector3d{0.0, 0.0, 9.81};
+  source("rotation") = Eigen::Matrix3d::Identity().eval();
+  source("vector") = Eigen::VectorXd::Ones(5).eval();
+  std::vector<char> buffer;
+  size_t size = source.serialize(buffer);
+
+  Dictionary target;
+  target("flag") = false;
+  target("count") = 0u;
+  target("offset") = 0;
+  target("name") = std::string("nemo");
+  target("servo")("left")("position") = 0.0;
+  target("imu")("orientation") = Eigen::Quaterniond::Identity();
+  target("rotation") = Eigen::Matrix3d::Zero().eval();
+  target("vector") = Eigen::VectorXd::Zero(5).eval();
+  const double *position = &target("servo")("left")("position").as<double>();
+  target.stream_update(buffer.data(), size);
+
+  ASSERT_EQ(target("flag").as<bool>(), true);
+  ASSERT_EQ(target("count").as<unsigned>(), 42u);
+  ASSERT_EQ(target("offset").as<int>(), -3);
+  ASSERT_EQ(target("name").as<std::string>(), "upkie");
+  ASSERT_DOUBLE_EQ(*position, 1.5);  // updated in place
+  ASSERT_DOUBLE_EQ(target("imu")("orientation").as<Eigen::Quaterniond>().x(),
+                   1.0);
+  ASSERT_TRUE(target("rotation").as<Eigen::Matrix3d>().isIdentity());
+  ASSERT_DOUBLE_EQ(target("vector").as<Eigen::VectorXd>().sum(), 5.0);
+
+  // Unknown keys are inserted as with update()
+  ASSERT_TRUE(target("imu").has("acceleration"));
+  ASSERT_DOUBLE_EQ(target("imu")("acceleration").as<Eigen::Vector3d>().z(),
+                   9.81);
+
+  // Streaming into an empty dictionary gives the same result as update()
+  Dictionary streamed, parsed;
+  streamed.stream_update(buffer.data(), size);
+  parsed.update(buffer.data(), size);
+  std::vector<char> streamed_buffer, parsed_buffer;
+  size_t streamed_size = streamed.serialize(streamed_buffer);
+  size_t parsed_size = parsed.serialize(parsed_buffer);
+  ASSERT_EQ(std::string(streamed_buffer.data(), streamed_size),
+            std::string(parsed_buffer.data(), parsed_size));
+}
+
+TEST(Dictionary, StreamUpdateErrors) {
+  Dictionary source;
+  source("foo")("bar") = 1.0;
+  source("foo")("name") = std::string("bar");
+  std::vector<char> buffer;
+  size_t size = source.serialize(buffer);
+
+  Dictionary wrong_type;
+  wrong_type("foo")("bar") = std::string("not a number");
+  ASSERT_THROW(wrong_type.stream_update(buffer.data(), size), TypeError);
+
+  Dictionary wrong_shape;
+  wrong_shape("foo") = 12.0;
+  ASSERT_THROW(wrong_shape.stream_update(buffer.data(), size), TypeError);
+
+  // Truncated messages are reported without throwing
+  Dictionary target;
+  target("foo")("bar") = 0.0;
+  target("foo")("name") = std::string("foo");
+  ASSERT_NO_THROW(target.stream_update(buffer.data(), size - 2));
+  ASSERT_DOUBLE_EQ(target("foo")("bar").as<double>(), 1.0);
+  ASSERT_EQ(target("foo")("name").as<std::string>(), "foo");
+}
+
+TEST(Dictionary, UpdateFromReader) {
+  Dictionary source;
+  source("foo")("bar") = 1.0;
+  source("foo")("new")("position") = Eigen::Vector3d{1.0, 2.0, 3.0};
+  std::vector<char> buffer;
+  size_t size = source.serialize(buffer);
+
+  // New keys are parsed again from the memory of the reader
+  Dictionary target;
+  target("foo")("bar") = 0.0;
+  mpack_reader_t reader;
+  mpack_reader_init_data(&reader, buffer.data(), size);
+  target.update(&reader);
+  ASSERT_EQ(mpack_reader_destroy(&reader), mpack_ok);
+  ASSERT_DOUBLE_EQ(target("foo")("bar").as<double>(), 1.0);
+  ASSERT_TRUE(target("foo")("new")("position").as<Eigen::Vector3d>().isApprox(
+      Eigen::Vector3d{1.0, 2.0, 3.0}));
+
+  // Readers with a fill function do not keep the bytes of skipped values
+  char stream_buffer[16];
+  mpack_reader_init(&reader, stream_buffer, sizeof(stream_buffer), 0);
+  mpack_reader_set_fill(
+      &reader, [](mpack_reader_t *, char *, size_t) -> size_t { return 0; });
+  ASSERT_THROW(target.update(&reader), PalimpsestError);
+  mpack_reader_destroy(&reader);
+}
+
+TEST(Dictionary, UpdateWithParser) {
+  Dictionary source;
+  source("servo")("position") = 1.0;
+  source("servo")("velocity") = 2.0;
+  source("name") = std::string("upkie");
+  std::vector<char> buffer;
+  size_t size = source.serialize(buffer);
+
+  mpack::Parser parser(2);
+  Dictionary target;
+  target.update(buffer.data(), size, parser);
+  const size_t capacity = parser.capacity();
+  for (int i = 0; i < 10; ++i) {
+    source("servo")("position") = static_cast<double>(i);
+    size = source.serialize(buffer);
+    target.update(buffer.data(), size, parser);
+    ASSERT_DOUBLE_EQ(target("servo")("position").as<double>(), i);
+    ASSERT_EQ(parser.capacity(), capacity);
+  }
+  ASSERT_EQ(target("name").as<std::string>(), "upkie");
+
+  // The parser remains usable after an exception
+  Dictionary wrong_shape;
+  wrong_shape("name")("first") = std::string("up");
+  ASSERT_THROW(wrong_shape.update(buffer.data(), size, parser), TypeError);
+  target.update(buffer.data(), size, parser);
+  ASSERT_DOUBLE_EQ(target("servo")("velocity").as<double>(), 2.0);
+}
+
+TEST(Dictionary, KeyOrderCache) {
+  Dictionary source;
+  source("servo")("left")("position") = 1.0;
+  source("servo")("right")("position") = 2.0;
+  source("time") = 3.0;
+  std::vector<char> buffer;
+  size_t size = source.serialize(buffer);
+
+  // Keys: servo, left, position, right, position, time
+  Dictionary target;
+  ASSERT_DOUBLE_EQ(target.key_order_stats().hit_rate(), 0.0);
+  target.update(buffer.data(), size);  // inserts all keys
+  target.update(buffer.data(), size);  // records the key order
+  ASSERT_EQ(target.key_order_stats().hits, 0);
+  ASSERT_EQ(target.key_order_stats().misses, 12);
+  target.update(buffer.data(), size);
+  target.stream_update(buffer.data(), size);
+  ASSERT_EQ(target.key_order_stats().hits, 12);
+  ASSERT_EQ(target.key_order_stats().misses, 12);
+  ASSERT_DOUBLE_EQ(target.key_order_stats().hit_rate(), 0.5);
+
+  // Keys in a different order are still updated correctly
+  Dictionary reordered;
+  reordered("time") = 4.0;
+  reordered("servo")("right")("position") = 5.0;
+  reordered("servo")("left")("position") = 6.0;
+  size = reordered.serialize(buffer);
+  target.update(buffer.data(), size);
+  ASSERT_DOUBLE_EQ(target("time").as<double>(), 4.0);
+  ASSERT_DOUBLE_EQ(target("servo")("right")("position").as<double>(), 5.0);
+  ASSERT_DOUBLE_EQ(target("servo")("left")("position").as<double>(), 6.0);
+  ASSERT_EQ(target.key_order_stats().hits, 14);  // both "position" keys
+
+  // Structural changes reset the predicted order
+  target("servo").remove("left");
+  target.update(buffer.data(), size);
+  ASSERT_TRUE(target("servo").has("left"));
+  ASSERT_DOUBLE_EQ(target("servo")("left")("position").as<double>(), 6.0);
+}
+
+TEST(Dictionary, SerializeToFixedBuffer) {
+  Dictionary dict;
+  for (int i = 0; i < 20; ++i) {
+    dict("servo")(std::to_string(i))("position") = 0.1 * i;
+  }
+  std::vector<char> buffer;
+  const size_t size = dict.serialize(buffer);
+
+  std::vector<char> memory(size);
+  auto result = dict.serialize(memory.data(), size / 2);
+  ASSERT_TRUE(result.insufficient_capacity());
+  ASSERT_EQ(result.size, 0);
+  ASSERT_EQ(result.required_size, size);
+
+  result = dict.serialize(memory.data(), result.required_size);
+  ASSERT_FALSE(result.insufficient_capacity());
+  ASSERT_EQ(result.size, size);
+  ASSERT_EQ(std::string(memory.data(), size), std::string(buffer.data(), size));
+}
+
+TEST(Dictionary, SerializeToWriter) {
+  Dictionary dict;
+  for (int i = 0; i < 200; ++i) {
+    dict("servo")(std::to_string(i))("position") = 0.1 * i;
+  }
+  std::vector<char> buffer;
+  const size_t size = dict.serialize(buffer);
+
+  mpack::Writer writer;
+  for (int message = 0; message < 3; ++message) {
+    dict("servo")("0")("position") = 1.0 * message;
+    dict.serialize(buffer);
+    ASSERT_EQ(dict.serialize(writer), size);
+    ASSERT_EQ(std::string(writer.data(), size),
+              std::string(buffer.data(), size));
+  }
+
+  std::vector<char> memory(size);
+  mpack::Writer fixed_writer(memory.data(), memory.size());
+  ASSERT_EQ(dict.serialize(fixed_writer), size);
+  ASSERT_EQ(dict.serialize(fixed_writer), size);
+  ASSERT_EQ(std::string(memory.data(), size), std::string(buffer.data(), size));
+}
+
+TEST(Dictionary, SerializeDelta) {
+  Dictionary source;
+  source("config")("name") = std::string("upkie");
+  source("config")("gains") = Eigen::Vector3d{1.0, 2.0, 3.0};
+  source("observation")("time") = 0.0;
+  source("observation")("imu")("acceleration") = Eigen::Vector3d::Zero().eval();
+  source("observation")("trajectory") = Eigen::VectorXd::Zero(5).eval();
+
+  // The first delta holds every value
+  std::vector<char> full;
+  std::vector<char> buffer;
+  Dictionary::DeltaBaseline baseline;
+  ASSERT_TRUE(baseline.empty());
+  const size_t full_size = source.serialize(full);
+  ASSERT_EQ(source.serialize_delta(buffer, baseline), full_size);
+  ASSERT_FALSE(baseline.empty());
+  ASSERT_EQ(std::string(buffer.data(), full_size),
+            std::string(full.data(), full_size));
+  Dictionary target;
+  target.update(buffer.data(), full_size);
+
+  // Unchanged values are left out
+  ASSERT_EQ(source.serialize_delta(buffer, baseline), 1);  // empty map
+  source("observation")("time") = 0.001;
+  source("observation")("trajectory").as<Eigen::VectorXd>()(2) = 1.0;
+  size_t size = source.serialize_delta(buffer, baseline);
+  ASSERT_LT(size, full_size / 2);
+  Dictionary delta;
+  delta.update(buffer.data(), size);
+  ASSERT_EQ(delta.keys(), std::vector<std::string>{"observation"});
+  ASSERT_FALSE(delta("observation").has("imu"));
+  ASSERT_DOUBLE_EQ(delta("observation")("time").as<double>(), 0.001);
+
+  // Deltas apply to the previous frame from a tree or a stream
+  Dictionary streamed;
+  streamed.update(full.data(), full_size);
+  target.update(buffer.data(), size);
+  streamed.stream_update(buffer.data(), size);
+  source.serialize(full);
+  for (const Dictionary *dict : {&target, &streamed}) {
+    std::vector<char> bytes;
+    ASSERT_EQ(dict->serialize(bytes), full_size);
+    ASSERT_EQ(std::string(bytes.data(), full_size),
+              std::string(full.data(), full_size));
+  }
+
+  // Values whose serialized size changes are detected as well
+  source("config")("name") = std::string("upkie_v2");
+  size = source.serialize_delta(buffer, baseline);
+  delta.clear();
+  delta.update(buffer.data(), size);
+  ASSERT_EQ(delta.keys(), std::vector<std::string>{"config"});
+  ASSERT_EQ(delta("config").keys(), std::vector<std::string>{"name"});
+
+  // Structural changes, or a reset baseline, start over with a full frame
+  source("observation")("imu")("orientation") = Eigen::Quaterniond::Identity();
+  ASSERT_EQ(source.serialize_delta(buffer, baseline),
+            source.serialize(full));
+  ASSERT_EQ(source.serialize_delta(buffer, baseline), 1);
+  baseline.reset();
+  ASSERT_EQ(source.serialize_delta(buffer, baseline),
+            source.serialized_size());
+
+  // A baseline belongs to the dictionary it was last used with
+  Dictionary other;
+  other("foo") = 1.0;
+  ASSERT_EQ(other.serialize_delta(buffer, baseline), other.serialized_size());
+}
+
+TEST(Dictionary, SerializeDeltaToMemory) {
+  Dictionary source;
+  source("name") = std::string("upkie");
+  source("time") = 0.0;
+  Dictionary::DeltaBaseline baseline;
+  char data[64];
+  Dictionary::SerializeResult result =
+      source.serialize_delta(data, sizeof(data), baseline);
+  ASSERT_FALSE(result.insufficient_capacity());
+  ASSERT_EQ(result.size, source.serialized_size());
+
+  source("time") = 0.001;
+  result = source.serialize_delta(data, sizeof(data), baseline);
+  ASSERT_FALSE(result.insufficient_capacity());
+  Dictionary delta;
+  delta.update(data, result.size);
+  ASSERT_EQ(delta.keys(), std::vector<std::string>{"time"});
+
+  // The baseline moves on even when the message does not fit
+  source("time") = 0.002;
+  result = source.serialize_delta(data, 4, baseline);
+  ASSERT_TRUE(result.insufficient_capacity());
+  ASSERT_EQ(result.size, 0);
+  ASSERT_EQ(result.required_size, 15);  // fixmap, fixstr "time", float 64
+  ASSERT_EQ(source.serialize_delta(data, sizeof(data), baseline).size, 1);
+}
+
+TEST(Dictionary, BinaryArrayEncoding) {
+  Eigen::Matrix3d rotation;
+  rotation << 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0;
+  Dictionary source;
+  source("position") = Eigen::Vector2d{1.0, 2.0};
+  source("acceleration") = Eigen::Vector3d{0.0, 0.0, 9.81};
+  source("rotation") = rotation;
+  source("trajectory") = Eigen::VectorXd::LinSpaced(1000, 0.0, 1.0).eval();
+  source("orientation") = Eigen::Quaterniond(0.0, 1.0, 0.0, 0.0);
+  mpack::Writer writer;
+  writer.set_array_encoding(mpack::ArrayEncoding::kBinary);
+  const size_t size = source.serialize(writer);
+  std::vector<char> buffer;
+  ASSERT_LT(size, source.serialize(buffer));
+
+  // Insert values of the inferred types
+  Dictionary inserted;
+  inserted.update(writer.data(), size);
+  ASSERT_EQ(inserted("position").as<Eigen::Vector2d>(),
+            Eigen::Vector2d(1.0, 2.0));
+  ASSERT_EQ(inserted("acceleration").as<Eigen::Vector3d>(),
+            Eigen::Vector3d(0.0, 0.0, 9.81));
+  ASSERT_EQ(inserted("rotation").as<Eigen::Matrix3d>(), rotation);
+  ASSERT_EQ(inserted("trajectory").as<Eigen::VectorXd>(),
+            source("trajectory").as<Eigen::VectorXd>());
+  ASSERT_DOUBLE_EQ(inserted("orientation").as<Eigen::Quaterniond>().x(), 1.0);
+
+  // Update existing values from a tree or a stream
+  for (bool stream : {false, true}) {
+    Dictionary target;
+    target("rotation") = Eigen::Matrix3d::Zero().eval();
+    target("trajectory") = Eigen::VectorXd::Zero(1000).eval();
+    if (stream) {
+      target.stream_update(writer.data(), size);
+    } else {
+      target.update(writer.data(), size);
+    }
+    ASSERT_EQ(target("rotation").as<Eigen::Matrix3d>(), rotation);
+    ASSERT_EQ(target("trajectory").as<Eigen::VectorXd>(),
+              source("trajectory").as<Eigen::VectorXd>());
+  }
+
+  // Shapes must match when updating existing values
+  Dictionary mismatch;
+  mismatch("trajectory") = Eigen::VectorXd::Zero(10).eval();
+  ASSERT_THROW(mismatch.update(writer.data(), size), TypeError);
+  ASSERT_THROW(mismatch.stream_update(writer.data(), size), TypeError);
+}
+
+TEST(Dictionary, SerializedSize) {
+  Dictionary dict;
+  ASSERT_EQ(dict.serialized_size(), 1);  // empty map
+  dict("flag") = true;
+  dict("count") = 12u;
+  dict("offset") = -1000;
+  dict("name") = std::string("upkie");
+  dict("imu")("orientation") = Eigen::Quaterniond::Identity();
+  dict("imu")("rotation") = Eigen::Matrix3d::Identity().eval();
+  dict("vector") = Eigen::VectorXd::Zero(3).eval();
+  for (int i = 0; i < 20; ++i) {
+    dict("servo")(std::to_string(i))("position") = 0.1 * i;
+  }
+  dict(std::string(40, 'k')) = 1.0;
+
+  std::vector<char> buffer;
+  ASSERT_EQ(dict.serialized_size(), dict.serialize(buffer));
+
+  // Variable-size values are measured on each call
+  dict("count") = 100000u;
+  dict("name") = std::string(50, 'a');
+  dict("vector").as<Eigen::VectorXd>().resize(20);
+  ASSERT_EQ(dict.serialized_size(), dict.serialize(buffer));
+
+  // Structural changes are taken into account
+  dict("servo").remove("3");
+  dict("extra") = std::string("foo");
+  ASSERT_EQ(dict.serialized_size(), dict.serialize(buffer));
+  ASSERT_EQ(dict("servo").serialized_size(), dict("servo").serialize(buffer));
+  ASSERT_EQ(dict("flag").serialized_size(), 1);
+}
+
+TEST(Dictionary, ChildReferencesAreStable) {
+  Dictionary dict;
+  Dictionary &first = dict("first");
+  first("value") = 1;
+  for (int i = 0; i < 100; ++i) {
+    dict(std::to_string(i))("value") = i;
+  }
+  ASSERT_EQ(&first, &dict("first"));
+  ASSERT_EQ(first("value").as<int>(), 1);
+}
+
+TEST(Dictionary, ResizePolicyDefaults) {
+  Dictionary dict;
+  dict("name") = std::string("foo");
+  dict("vector") = Eigen::VectorXd::Zero(3).eval();
+  dict.insert<std::vector<double>>("list", 3, 0.0);
+  dict("number") = 1.0;
+  ASSERT_EQ(dict("name").resize_policy(), mpack::ResizePolicy::kGrow);
+  ASSERT_EQ(dict("vector").resize_policy(), mpack::ResizePolicy::kError);
+  ASSERT_EQ(dict("list").resize_policy(), mpack::ResizePolicy::kGrow);
+  ASSERT_THROW(dict("number").resize_policy(), TypeError);
+  ASSERT_THROW(dict.resize_policy(), TypeError);
+  ASSERT_THROW(dict("number").set_resize_policy(mpack::ResizePolicy::kError),
+               TypeError);
+  ASSERT_THROW(dict("vector").reserve(10), TypeError);
+  ASSERT_THROW(dict.reserve(10), TypeError);
+
+  // Maps set the policy of all values of their tree that have one
+  dict.set_resize_policy(mpack::ResizePolicy::kTruncate);
+  ASSERT_EQ(dict("name").resize_policy(), mpack::ResizePolicy::kTruncate);
+  ASSERT_EQ(dict("vector").resize_policy(), mpack::ResizePolicy::kTruncate);
+  ASSERT_EQ(dict("list").resize_policy(), mpack::ResizePolicy::kTruncate);
+
+  // Policies are kept when freezing
+  dict.freeze();
+  ASSERT_EQ(dict("name").resize_policy(), mpack::ResizePolicy::kTruncate);
+}
+
+TEST(Dictionary, UpdateStringInPlace) {
+  Dictionary source;
+  source("name") = std::string(40, 'a');
+  std::vector<char> buffer;
+  const size_t size = source.serialize(buffer);
+
+  for (bool stream : {false, true}) {
+    Dictionary dict;
+    dict("name") = std::string("b");
+    dict("name").reserve(64);
+    const char *data = dict("name").as<std::string>().data();
+    if (stream) {
+      dict.stream_update(buffer.data(), size);
+    } else {
+      dict.update(buffer.data(), size);
+    }
+    ASSERT_EQ(dict("name").as<std::string>(), std::string(40, 'a'));
+    ASSERT_EQ(dict("name").as<std::string>().data(), data);
+  }
+
+  for (bool stream : {false, true}) {
+    Dictionary dict;
+    dict("name") = std::string("b");
+    dict("name").reserve(20);
+    const size_t capacity = dict("name").as<std::string>().capacity();
+    const char *data = dict("name").as<std::string>().data();
+    dict("name").set_resize_policy(mpack::ResizePolicy::kTruncate);
+    if (stream) {
+      dict.stream_update(buffer.data(), size);
+    } else {
+      dict.update(buffer.data(), size);
+    }
+    ASSERT_EQ(dict("name").as<std::string>(), std::string(capacity, 'a'));
+    ASSERT_EQ(dict("name").as<std::string>().data(), data);
+
+    dict("name").set_resize_policy(mpack::ResizePolicy::kError);
+    if (stream) {
+      ASSERT_THROW(dict.stream_update(buffer.data(), size), TypeError);
+    } else {
+      ASSERT_THROW(dict.update(buffer.data(), size), TypeError);
+    }
+  }
+}
+
+TEST(Dictionary, UpdateVectorXdResizePolicies) {
+  Dictionary source;
+  source("vector") = Eigen::VectorXd::LinSpaced(6, 1.0, 6.0).eval();
+  std::vector<char> buffer;
+  const size_t size = source.serialize(buffer);
+  const Eigen::VectorXd &expected = source("vector").as<Eigen::VectorXd>();
+
+  for (bool stream : {false, true}) {
+    auto update = [&](Dictionary &dict) {
+      if (stream) {
+        dict.stream_update(buffer.data(), size);
+      } else {
+        dict.update(buffer.data(), size);
+      }
+    };
+
+    Dictionary dict;
+    dict("vector") = Eigen::VectorXd::Zero(4).eval();
+    ASSERT_THROW(update(dict), TypeError);
+
+    dict("vector").set_resize_policy(mpack::ResizePolicy::kTruncate);
+    update(dict);
+    ASSERT_EQ(dict("vector").as<Eigen::VectorXd>(), expected.head(4));
+
+    dict("vector") = Eigen::VectorXd::Zero(8).eval();
+    update(dict);
+    ASSERT_EQ(dict("vector").as<Eigen::VectorXd>().head(6), expected);
+    ASSERT_EQ(dict("vector").as<Eigen::VectorXd>().tail(2),
+              Eigen::VectorXd::Zero(2));
+
+    dict("vector").set_resize_policy(mpack::ResizePolicy::kGrow);
+    update(dict);
+    ASSERT_EQ(dict("vector").as<Eigen::VectorXd>(), expected);
+  }
+}
+
+TEST(Dictionary, UpdateStdVectorInPlace) {
+  Dictionary source;
+  source.insert<std::vector<double>>("list", 5, 1.5);
+  source.insert<std::vector<std::string>>("names", 3, "servo");
+  std::vector<char> buffer;
+  const size_t size = source.serialize(buffer);
+
+  for (bool stream : {false, true}) {
+    Dictionary dict;
+    auto &list = dict.insert<std::vector<double>>("list");
+    auto &names = dict.insert<std::vector<std::string>>("names");
+    dict("list").reserve(8);
+    dict("names").reserve(2);
+    dict.set_resize_policy(mpack::ResizePolicy::kTruncate);
+    const double *data = list.data();
+    if (stream) {
+      dict.stream_update(buffer.data(), size);
+    } else {
+      dict.update(buffer.data(), size);
+    }
+    ASSERT_EQ(list, std::vector<double>(5, 1.5));
+    ASSERT_EQ(list.data(), data);
+    ASSERT_EQ(names, std::vector<std::string>(2, "servo"));
+  }
+}
+
+TEST(Dictionary, UpdateStdVectorNewElements) {
+  Dictionary source;
+  source.insert<std::vector<Eigen::VectorXd>>("vectors", 3,
+                                              Eigen::VectorXd::Ones(20));
+  source.insert<std::vector<std::string>>("names", 2, std::string(40, 'a'));
+  std::vector<char> buffer;
+  const size_t size = source.serialize(buffer);
+
+  // The policy applies to the vectors and their elements, not to elements
+  // the update appends, which start without capacity
+  for (auto policy : {mpack::ResizePolicy::kError,
+                      mpack::ResizePolicy::kTruncate}) {
+    for (bool stream : {false, true}) {
+      Dictionary dict;
+      auto &vectors = dict.insert<std::vector<Eigen::VectorXd>>(
+          "vectors", 1, Eigen::VectorXd::Zero(20));
+      auto &names = dict.insert<std::vector<std::string>>("names");
+      dict("vectors").reserve(3);
+      dict("names").reserve(2);
+      dict.set_resize_policy(policy);
+      if (stream) {
+        dict.stream_update(buffer.data(), size);
+      } else {
+        dict.update(buffer.data(), size);
+      }
+      ASSERT_EQ(vectors.size(), 3);
+      for (const auto &vector : vectors) {
+        ASSERT_EQ(vector, Eigen::VectorXd::Ones(20));
+      }
+      ASSERT_EQ(names, std::vector<std::string>(2, std::string(40, 'a')));
+    }
+  }
+}
+
 }  // namespace palimpsest
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/LogReader.h"
+
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "palimpsest/Dictionary.h"
+#include "palimpsest/Logger.h"
+#include "palimpsest/exceptions/SystemError.h"
+
+namespace palimpsest {
+
+using exceptions::SystemError;
+
+namespace {
+
+//! Number of frames in test logs.
+constexpr int kNbFrames = 1000;
+
+/*! Write a test log where frame i holds the time 0.001 * i.
+ *
+ * @param[in] index_interval Minimum number of frames between index blocks,
+ *     zero for a plain log.
+ * @param[in] keyframe_interval Maximum number of frames between keyframes,
+ *     zero to write only keyframes.
+ * @return Path to the log file.
+ */
+std::string write_log(size_t index_interval, size_t keyframe_interval = 0) {
+  char path[] = "/tmp/logreaderXXXXXX";
+  ::close(::mkstemp(path));
+  Logger logger(path, 1024, 64, Logger::SyncPolicy::kNone,
+                std::chrono::seconds(1), index_interval);
+  logger.set_delta_encoding(keyframe_interval, std::chrono::hours(1));
+  Dictionary dict;
+  for (int frame = 0; frame < kNbFrames; ++frame) {
+    dict("time") = 0.001 * frame;
+    dict("servo")("position") = static_cast<double>(frame);
+    dict("servo")("mode") =
+        std::string((frame < kNbFrames / 2) ? "position" : "stop");
+    dict("servo")("name") = std::string("left_knee");
+    while (!logger.write(dict)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  return path;
+}
+
+//! Check that frames of a log are read back in any order.
+void check_frames(const LogReader &log) {
+  ASSERT_EQ(log.nb_frames(), kNbFrames);
+  Dictionary dict;
+  for (int frame : {0, 999, 500, 1, 16, 15, 17, 998, 123}) {
+    log.read(frame, dict);
+    ASSERT_DOUBLE_EQ(dict("time").as<double>(), 0.001 * frame);
+    ASSERT_DOUBLE_EQ(dict("servo")("position").as<double>(), frame);
+  }
+  ASSERT_THROW(log.frame(kNbFrames), std::out_of_range);
+}
+
+}  // namespace
+
+TEST(LogReader, IndexedLog) {
+  const std::string path = write_log(16);
+  LogReader log(path);
+  ASSERT_TRUE(log.is_indexed());
+  check_frames(log);
+  ::unlink(path.c_str());
+}
+
+TEST(LogReader, PlainLog) {
+  const std::string path = write_log(0);
+  LogReader log(path);
+  ASSERT_FALSE(log.is_indexed());
+  check_frames(log);
+  ::unlink(path.c_str());
+}
+
+TEST(LogReader, DeltaFrames) {
+  for (size_t index_interval : {16, 0}) {
+    const std::string plain_path = write_log(index_interval);
+    const std::string path = write_log(index_interval, 10);
+    LogReader log(path);
+    ASSERT_EQ(log.is_indexed(), index_interval > 0);
+    ASSERT_EQ(log.nb_frames(), kNbFrames);
+    ASSERT_TRUE(log.is_keyframe(0));
+    ASSERT_FALSE(log.is_keyframe(1));
+    ASSERT_FALSE(log.is_keyframe(9));
+    ASSERT_TRUE(log.is_keyframe(10));
+
+    // Delta frames skip the name and mode, which rarely change
+    ASSERT_LT(log.frame(1).size(), log.frame(0).size());
+    struct stat plain_stat, delta_stat;
+    ASSERT_EQ(::stat(plain_path.c_str(), &plain_stat), 0);
+    ASSERT_EQ(::stat(path.c_str(), &delta_stat), 0);
+    ASSERT_LT(delta_stat.st_size, plain_stat.st_size);
+    for (int frame : {999, 0, 500, 501, 509, 510, 1, 123}) {
+      Dictionary dict;
+      log.replay(frame, dict);
+      ASSERT_DOUBLE_EQ(dict("time").as<double>(), 0.001 * frame);
+      ASSERT_DOUBLE_EQ(dict("servo")("position").as<double>(), frame);
+      ASSERT_EQ(dict("servo")("mode").as<std::string>(),
+                (frame < 500) ? "position" : "stop");
+      ASSERT_EQ(dict("servo")("name").as<std::string>(), "left_knee");
+    }
+    ::unlink(plain_path.c_str());
+    ::unlink(path.c_str());
+  }
+}
+
+TEST(LogReader, IndexedLogWithoutFooter) {
+  const std::string path = write_log(16);
+  std::uint64_t footer_offset = 0;
+  {
+    LogReader log(path);
+    const std::string_view last = log.frame(kNbFrames - 1);
+    ASSERT_TRUE(log.is_indexed());
+
+    // Cut the log after its last frame, as if its writer had crashed
+    footer_offset = static_cast<std::uint64_t>(
+        last.data() + last.size() - log.frame(0).data());
+  }
+  ASSERT_EQ(::truncate(path.c_str(), static_cast<off_t>(footer_offset)), 0);
+
+  // Index blocks are skipped when scanning the log
+  LogReader log(path);
+  ASSERT_FALSE(log.is_indexed());
+  check_frames(log);
+  ::unlink(path.c_str());
+}
+
+TEST(LogReader, TruncatedFrame) {
+  const std::string path = write_log(0);
+  off_t size = 0;
+  {
+    LogReader log(path);
+    const std::string_view last = log.frame(kNbFrames - 1);
+    size = static_cast<off_t>(last.data() - log.frame(0).data() + 3);
+  }
+  ASSERT_EQ(::truncate(path.c_str(), size), 0);
+  LogReader log(path);
+  ASSERT_EQ(log.nb_frames(), kNbFrames - 1);
+  Dictionary dict;
+  log.read(kNbFrames - 2, dict);
+  ASSERT_DOUBLE_EQ(dict("time").as<double>(), 0.001 * (kNbFrames - 2));
+  ::unlink(path.c_str());
+}
+
+TEST(LogReader, EmptyLog) {
+  char path[] = "/tmp/logreaderXXXXXX";
+  ::close(::mkstemp(path));
+  {
+    LogReader log(path);
+    ASSERT_EQ(log.nb_frames(), 0);
+    ASSERT_THROW(log.frame(0), std::out_of_range);
+  }
+  {
+    Logger logger(path, 1024, 64, Logger::SyncPolicy::kNone,
+                  std::chrono::seconds(1), 16);
+  }
+  LogReader log(path);
+  ASSERT_TRUE(log.is_indexed());
+  ASSERT_EQ(log.nb_frames(), 0);
+  ::unlink(path);
+}
+
+TEST(LogReader, OpenMissingLog) {
+  ASSERT_THROW(LogReader("/nonexistent/log.mpack"), SystemError);
+}
+
+}  // namespace palimpsest
@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/Logger.h"
+
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <csignal>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "palimpsest/Dictionary.h"
+#include "palimpsest/LogReader.h"
+#include "palimpsest/exceptions/SystemError.h"
+
+namespace palimpsest {
+
+using exceptions::SystemError;
+
+namespace {
+
+//! Create an empty temporary file and return its path.
+std::string make_temporary_file() {
+  char path[] = "/tmp/loggerXXXXXX";
+  const int fd = ::mkstemp(path);
+  ::close(fd);
+  return path;
+}
+
+/*! Read the value at a key of every frame of a log file.
+ *
+ * @param[in] path Path to the log file.
+ * @param[in] key Key of a double value in every frame.
+ * @return Values read, in file order.
+ */
+std::vector<double> read_log(const std::string &path, const std::string &key) {
+  std::ifstream file(path, std::ifstream::binary);
+  const std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+  mpack_reader_t reader;
+  mpack_reader_init_data(&reader, data.data(), data.size());
+  std::vector<double> values;
+  Dictionary frame;
+  frame(key) = 0.0;
+  while (mpack_reader_remaining(&reader, nullptr) > 0) {
+    frame.update(&reader);
+    values.push_back(frame(key).as<double>());
+  }
+  EXPECT_EQ(mpack_reader_destroy(&reader), mpack_ok);
+  return values;
+}
+
+}  // namespace
+
+TEST(Logger, WriteFrames) {
+  const std::string path = make_temporary_file();
+  {
+    Logger logger(path, 1024, /* nb_slots = */ 128);
+    Dictionary dict;
+    for (int frame = 0; frame < 100; ++frame) {
+      dict("time") = 0.001 * frame;
+      ASSERT_TRUE(logger.write(dict));
+    }
+  }
+  const std::vector<double> times = read_log(path, "time");
+  ASSERT_EQ(times.size(), 100);
+  for (size_t frame = 0; frame < times.size(); ++frame) {
+    ASSERT_DOUBLE_EQ(times[frame], 0.001 * frame);
+  }
+  ::unlink(path.c_str());
+}
+
+TEST(Logger, WriteBytes) {
+  const std::string path = make_temporary_file();
+  Dictionary dict;
+  dict("time") = 1.0;
+  std::vector<char> buffer;
+  const size_t size = dict.serialize(buffer);
+  {
+    Logger logger(path, size);
+    ASSERT_TRUE(logger.write(buffer.data(), size));
+    ASSERT_FALSE(logger.write(buffer.data(), size + 1));
+  }
+  ASSERT_EQ(read_log(path, "time"), std::vector<double>{1.0});
+  ::unlink(path.c_str());
+}
+
+TEST(Logger, DropFrames) {
+  const std::string path = make_temporary_file();
+  constexpr int kNbFrames = 10000;
+  std::uint64_t written_frames = 0;
+  {
+    Logger logger(path, 64, /* nb_slots = */ 2);
+    Dictionary dict;
+    dict("time") = 0.0;
+    for (int frame = 0; frame < kNbFrames; ++frame) {
+      dict("time") = static_cast<double>(frame);
+      logger.write(dict);
+      ASSERT_LE(logger.queue_depth(), 2);
+    }
+
+    // Frames that don't fit in a slot are dropped as well
+    dict("name") = std::string(100, 'a');
+    ASSERT_FALSE(logger.write(dict));
+
+    ASSERT_LE(logger.max_queue_depth(), 2);
+    while (logger.queue_depth() > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    written_frames = logger.written_frames();
+    ASSERT_EQ(written_frames + logger.dropped_frames(), kNbFrames + 1);
+  }
+
+  // Frames that were not dropped are written in order
+  const std::vector<double> times = read_log(path, "time");
+  ASSERT_EQ(times.size(), written_frames);
+  for (size_t i = 1; i < times.size(); ++i) {
+    ASSERT_LT(times[i - 1], times[i]);
+  }
+  ::unlink(path.c_str());
+}
+
+TEST(Logger, KeyframeAfterStructuralChange) {
+  const std::string path = make_temporary_file();
+  {
+    Logger logger(path, 1024, 8);
+    logger.set_delta_encoding(100, std::chrono::hours(1));
+    Dictionary dict;
+    dict("a") = 1.0;
+    for (int frame = 0; frame < 4; ++frame) {
+      if (frame == 2) {
+        dict("b") = 2.0;
+      }
+      dict("a") = static_cast<double>(frame);
+      while (!logger.write(dict)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  }
+
+  // The frame after the new key holds every value, and is marked so
+  LogReader log(path);
+  ASSERT_EQ(log.nb_frames(), 4);
+  ASSERT_TRUE(log.is_keyframe(0));
+  ASSERT_FALSE(log.is_keyframe(1));
+  ASSERT_TRUE(log.is_keyframe(2));
+  ASSERT_FALSE(log.is_keyframe(3));
+  Dictionary dict;
+  log.read(2, dict);
+  ASSERT_DOUBLE_EQ(dict("a").as<double>(), 2.0);
+  ASSERT_DOUBLE_EQ(dict("b").as<double>(), 2.0);
+  log.replay(3, dict);
+  ASSERT_DOUBLE_EQ(dict("a").as<double>(), 3.0);
+  ::unlink(path.c_str());
+}
+
+TEST(Logger, WriteFailure) {
+  // Writes to /dev/full fail with ENOSPC
+  Logger logger("/dev/full", 1024, 8);
+  logger.set_delta_encoding(100, std::chrono::hours(1));
+  Dictionary dict;
+  for (int frame = 0; frame < 20; ++frame) {
+    dict("time") = static_cast<double>(frame);
+    logger.write(dict);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  while (logger.queue_depth() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(logger.written_frames(), 0);
+  ASSERT_EQ(logger.dropped_frames(), 20);
+}
+
+TEST(Logger, PartialWriteFailure) {
+  const std::string path = make_temporary_file();
+  Dictionary dict;
+  dict("time") = 0.0;
+  dict("name") = std::string("left_knee");
+  const size_t frame_size = dict.serialized_size();
+
+  // Writes beyond the size limit fail with EFBIG, after writing the bytes
+  // up to the limit in the middle of a frame
+  constexpr rlim_t kFileSizeLimit = 1000;
+  ASSERT_NE(kFileSizeLimit % frame_size, 0);
+  struct rlimit limit;
+  ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &limit), 0);
+  struct rlimit small_limit = limit;
+  small_limit.rlim_cur = kFileSizeLimit;
+  auto *previous_handler = ::signal(SIGXFSZ, SIG_IGN);
+  ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &small_limit), 0);
+  std::uint64_t written_frames = 0;
+  {
+    Logger logger(path, 1024, /* nb_slots = */ 128);
+    for (int frame = 0; frame < 100; ++frame) {
+      dict("time") = static_cast<double>(frame);
+      ASSERT_TRUE(logger.write(dict));
+    }
+    while (logger.queue_depth() > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    written_frames = logger.written_frames();
+    ASSERT_EQ(written_frames, kFileSizeLimit / frame_size);
+    ASSERT_EQ(written_frames + logger.dropped_frames(), 100);
+  }
+  ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limit), 0);
+  ::signal(SIGXFSZ, previous_handler);
+
+  // The torn frame was removed, so that the log parses frame by frame
+  const std::vector<double> times = read_log(path, "time");
+  ASSERT_EQ(times.size(), written_frames);
+  for (size_t frame = 0; frame < times.size(); ++frame) {
+    ASSERT_DOUBLE_EQ(times[frame], static_cast<double>(frame));
+  }
+  ::unlink(path.c_str());
+}
+
+TEST(Logger, SyncPolicies) {
+  for (auto policy :
+       {Logger::SyncPolicy::kNone, Logger::SyncPolicy::kPeriodic,
+        Logger::SyncPolicy::kEveryBatch}) {
+    const std::string path = make_temporary_file();
+    {
+      Logger logger(path, 1024, 8, policy, std::chrono::milliseconds(0));
+      Dictionary dict;
+      for (int frame = 0; frame < 20; ++frame) {
+        dict("time") = static_cast<double>(frame);
+        while (!logger.write(dict)) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+    }
+    ASSERT_EQ(read_log(path, "time").size(), 20);
+    ::unlink(path.c_str());
+  }
+}
+
+TEST(Logger, OpenFails) {
+  ASSERT_THROW(Logger("/nonexistent/directory/log.mpack"), SystemError);
+}
+
+}  // namespace palimpsest
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/ShmChannel.h"
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <Eigen/Core>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "palimpsest/Dictionary.h"
+#include "palimpsest/exceptions/PalimpsestError.h"
+#include "palimpsest/exceptions/SystemError.h"
+
+namespace palimpsest {
+
+using exceptions::PalimpsestError;
+using exceptions::SystemError;
+
+namespace {
+
+//! Name of a shared-memory object unique to this test process.
+std::string channel_name(const std::string &suffix) {
+  return "/palimpsest_test_" + std::to_string(::getpid()) + "_" + suffix;
+}
+
+}  // namespace
+
+TEST(ShmChannel, WriteAndUpdate) {
+  ShmChannel writer(channel_name("write"), 1024);
+  ShmChannel reader(writer.name());
+  ASSERT_TRUE(writer.is_writer());
+  ASSERT_FALSE(reader.is_writer());
+  ASSERT_EQ(reader.capacity(), 1024);
+  ASSERT_EQ(reader.frame(), 0);
+
+  Dictionary target;
+  ASSERT_FALSE(reader.update(target));
+
+  Dictionary source;
+  source("position") = Eigen::Vector3d{1.0, 2.0, 3.0};
+  source("name") = std::string("upkie");
+  const Dictionary::SerializeResult result = writer.write(source);
+  ASSERT_FALSE(result.insufficient_capacity());
+  ASSERT_EQ(reader.frame(), 1);
+
+  ASSERT_TRUE(reader.update(target));
+  ASSERT_EQ(reader.last_read_frame(), 1);
+  ASSERT_EQ(target("position").as<Eigen::Vector3d>(),
+            Eigen::Vector3d(1.0, 2.0, 3.0));
+  ASSERT_EQ(target("name").as<std::string>(), "upkie");
+
+  // Frames are read once
+  ASSERT_FALSE(reader.update(target));
+
+  // Readers get the latest frame
+  source("position") = Eigen::Vector3d{4.0, 5.0, 6.0};
+  writer.write(source);
+  source("position") = Eigen::Vector3d{7.0, 8.0, 9.0};
+  writer.write(source);
+  ASSERT_TRUE(reader.update(target));
+  ASSERT_EQ(reader.last_read_frame(), 3);
+  ASSERT_EQ(target("position").as<Eigen::Vector3d>(),
+            Eigen::Vector3d(7.0, 8.0, 9.0));
+}
+
+TEST(ShmChannel, InsufficientCapacity) {
+  ShmChannel writer(channel_name("capacity"), 16);
+  ShmChannel reader(writer.name());
+  Dictionary source;
+  source("foo") = 1.0;
+  ASSERT_FALSE(writer.write(source).insufficient_capacity());
+
+  source("trajectory") = Eigen::VectorXd::Zero(10).eval();
+  const Dictionary::SerializeResult result = writer.write(source);
+  ASSERT_TRUE(result.insufficient_capacity());
+  ASSERT_EQ(result.required_size, source.serialized_size());
+  ASSERT_EQ(writer.frame(), 1);
+
+  // The previous frame is still readable
+  Dictionary target;
+  ASSERT_TRUE(reader.update(target));
+  ASSERT_DOUBLE_EQ(target("foo").as<double>(), 1.0);
+
+  std::vector<char> bytes(17, '\x00');
+  ASSERT_FALSE(writer.write(bytes.data(), bytes.size()));
+}
+
+TEST(ShmChannel, ReaderCannotWrite) {
+  ShmChannel writer(channel_name("reader"), 64);
+  ShmChannel reader(writer.name());
+  Dictionary dict;
+  ASSERT_THROW(reader.write(dict), SystemError);
+}
+
+TEST(ShmChannel, OpenMissingChannel) {
+  ASSERT_THROW(ShmChannel(channel_name("missing")), SystemError);
+}
+
+TEST(ShmChannel, WriterUnlinksOnDestruction) {
+  const std::string name = channel_name("unlink");
+  { ShmChannel writer(name, 64); }
+  ASSERT_THROW(ShmChannel{name}, SystemError);
+}
+
+TEST(ShmChannel, FramesAreNeverTorn) {
+  constexpr int kNbFrames = 20000;
+  constexpr Eigen::Index kSize = 100;
+  ShmChannel writer(channel_name("torn"), 4096);
+  ShmChannel reader(writer.name());
+
+  std::atomic<bool> done = false;
+  std::thread writer_thread([&]() {
+    Dictionary source;
+    source("values") = Eigen::VectorXd::Zero(kSize).eval();
+    auto &values = source("values").as<Eigen::VectorXd>();
+    for (int frame = 1; frame <= kNbFrames; ++frame) {
+      values.setConstant(static_cast<double>(frame));
+      writer.write(source);
+    }
+    done = true;
+  });
+
+  Dictionary target;
+  target("values") = Eigen::VectorXd::Zero(kSize).eval();
+  const auto &values = target("values").as<Eigen::VectorXd>();
+  int nb_reads = 0;
+  double last_value = 0.0;
+  while (!done || reader.last_read_frame() < writer.frame()) {
+    if (reader.update(target)) {
+      ASSERT_EQ(values.minCoeff(), values.maxCoeff()) << "torn frame";
+      ASSERT_EQ(values(0), static_cast<double>(reader.last_read_frame()));
+      ASSERT_GE(values(0), last_value);
+      last_value = values(0);
+      ++nb_reads;
+    }
+  }
+  writer_thread.join();
+  ASSERT_GT(nb_reads, 0);
+  ASSERT_EQ(last_value, static_cast<double>(kNbFrames));
+}
+
+TEST(ShmChannel, BoundedReadRetries) {
+  constexpr size_t kCapacity = 256;
+  ShmChannel writer(channel_name("retries"), kCapacity);
+  ShmChannel reader(writer.name());
+  Dictionary source;
+  source("time") = 1.0;
+  writer.write(source);
+
+  // Map the header of the slot of frame 1, following the layout of channels:
+  // a 128-byte header, then slots of 64-byte headers followed by frames
+  const int fd = ::shm_open(writer.name().c_str(), O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  const size_t stride = (64 + kCapacity + 63) / 64 * 64;
+  const size_t size = 128 + 2 * stride;
+  void *mapping =
+      ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  ASSERT_NE(mapping, MAP_FAILED);
+  auto *slot = reinterpret_cast<std::atomic<std::uint64_t> *>(
+      static_cast<char *>(mapping) + 128 + stride);
+  auto &sequence = slot[0];
+  auto &frame_size = slot[2];
+  ASSERT_EQ(sequence.load() % 2, 0);
+
+  // A writer stopped in the middle of the frame does not block readers
+  std::vector<char> data(kCapacity);
+  sequence.fetch_add(1);
+  ASSERT_EQ(reader.read(data.data()), 0);
+  ASSERT_EQ(reader.last_read_frame(), 0);
+  sequence.fetch_add(1);
+
+  // Sizes beyond capacity are never retried
+  const std::uint64_t frame_bytes = frame_size.load();
+  frame_size.store(kCapacity + 1);
+  ASSERT_THROW(reader.read(data.data()), PalimpsestError);
+  frame_size.store(frame_bytes);
+  ASSERT_EQ(reader.read(data.data()), frame_bytes);
+  ASSERT_EQ(reader.last_read_frame(), 1);
+  ::munmap(mapping, size);
+}
+
+}  // namespace palimpsest
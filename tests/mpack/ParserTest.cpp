@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/mpack/Parser.h"
+
+#include <gtest/gtest.h>
+#include <mpack.h>
+
+#include <string>
+#include <vector>
+
+#include "palimpsest/mpack/Writer.h"
+
+namespace palimpsest::mpack {
+
+class ParserTest : public ::testing::Test {
+ protected:
+  /*! Write an array of integers to the buffer.
+   *
+   * @param[in] length Number of integers in the array.
+   * @return Size of the message.
+   */
+  size_t write_array(unsigned length) {
+    Writer writer(buffer_);
+    writer.start_array(length);
+    for (unsigned i = 0; i < length; ++i) {
+      writer.write(i);
+    }
+    writer.finish_array();
+    return writer.finish();
+  }
+
+ protected:
+  //! Internal byte buffer
+  std::vector<char> buffer_;
+};
+
+TEST_F(ParserTest, Parse) {
+  Parser parser;
+  ASSERT_EQ(parser.error(), mpack_ok);
+  size_t size = write_array(3);
+  mpack_node_t root = parser.parse(buffer_.data(), size);
+  ASSERT_EQ(parser.error(), mpack_ok);
+  ASSERT_EQ(mpack_node_type(root), mpack_type_array);
+  ASSERT_EQ(mpack_node_array_length(root), 3);
+  ASSERT_EQ(mpack_node_uint(mpack_node_array_at(root, 2)), 2u);
+}
+
+TEST_F(ParserTest, PoolGrowsThenStays) {
+  Parser parser(4);
+  ASSERT_EQ(parser.capacity(), 4);
+  size_t size = write_array(100);
+  mpack_node_t root = parser.parse(buffer_.data(), size);
+  ASSERT_EQ(parser.error(), mpack_ok);
+  ASSERT_EQ(mpack_node_array_length(root), 100);
+  const size_t capacity = parser.capacity();
+  ASSERT_GE(capacity, 101);
+
+  for (int i = 0; i < 10; ++i) {
+    root = parser.parse(buffer_.data(), size);
+    ASSERT_EQ(parser.error(), mpack_ok);
+    ASSERT_EQ(parser.capacity(), capacity);
+  }
+}
+
+TEST_F(ParserTest, InvalidMessage) {
+  Parser parser;
+  size_t size = write_array(3);
+  mpack_node_t root = parser.parse(buffer_.data(), size - 1);
+  ASSERT_NE(parser.error(), mpack_ok);
+  ASSERT_EQ(mpack_node_type(root), mpack_type_nil);
+
+  // The parser can be reused after an error
+  root = parser.parse(buffer_.data(), size);
+  ASSERT_EQ(parser.error(), mpack_ok);
+  ASSERT_EQ(mpack_node_array_length(root), 3);
+}
+
+}  // namespace palimpsest::mpack
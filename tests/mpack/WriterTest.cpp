@@ -14,8 +14,11 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include "palimpsest/exceptions/PalimpsestError.h"
 #include "palimpsest/mpack/Writer.h"
 
 namespace palimpsest::mpack {
@@ -85,6 +88,145 @@ TEST_F(WriterTest, FloatingPoint) {
   ASSERT_NO_THROW(writer_->write(42.0));
 }
 
+TEST_F(WriterTest, Strings) {
+  const std::string foobar = "foobar";
+  writer_->start_array(3);
+  writer_->write(foobar);
+  writer_->write(std::string_view(foobar).substr(0, 3));
+  writer_->write("bar");
+  writer_->finish_array();
+  size_t size = writer_->finish();
+  ASSERT_EQ(size, 1 + 7 + 4 + 4);
+  ASSERT_EQ(std::string(buffer_.data() + 8, 4), "\xa3" "foo");
+}
+
+#if !MPACK_WRITE_TRACKING
+TEST_F(WriterTest, PreEncodedBytes) {
+  writer_->start_array(2);
+  writer_->write_bytes("\xa3" "foo", 4);
+  writer_->write("bar");
+  writer_->finish_array();
+  size_t size = writer_->finish();
+  ASSERT_EQ(size, 1 + 4 + 4);
+  ASSERT_EQ(std::string(buffer_.data(), size), "\x92\xa3" "foo\xa3" "bar");
+}
+#endif
+
+TEST(Writer, FixedBuffer) {
+  std::vector<char> reference_buffer;
+  Writer reference(reference_buffer);
+  reference.write(std::string(100, 'a'));
+  reference.write(Eigen::Vector3d{1.0, 2.0, 3.0});
+  const size_t reference_size = reference.finish();
+
+  for (size_t capacity : {size_t(0), size_t(4), size_t(64), size_t(120),
+                          reference_size, size_t(1000)}) {
+    std::vector<char> memory(capacity + 1, '\x42');
+    Writer writer(memory.data(), capacity);
+    writer.write(std::string(100, 'a'));
+    writer.write(Eigen::Vector3d{1.0, 2.0, 3.0});
+    const size_t size = writer.finish();
+    ASSERT_EQ(writer.required_size(), reference_size);
+    ASSERT_EQ(memory[capacity], '\x42');  // nothing written past capacity
+    if (capacity >= reference_size) {
+      ASSERT_EQ(size, reference_size);
+      ASSERT_EQ(std::string(memory.data(), size),
+                std::string(reference_buffer.data(), reference_size));
+    } else {
+      ASSERT_EQ(size, 0);
+    }
+  }
+}
+
+TEST(Writer, SmallFixedBuffer) {
+  char memory[8];
+  Writer writer(memory, sizeof(memory));
+  writer.write("foo");
+  ASSERT_EQ(writer.finish(), 4);
+  ASSERT_EQ(writer.required_size(), 4);
+  ASSERT_EQ(std::string(memory, 4), "\xa3" "foo");
+}
+
+TEST(Writer, CountBytesWithoutBuffer) {
+  Writer writer(nullptr, 0);
+  writer.write(Eigen::VectorXd::Zero(300).eval());
+  ASSERT_EQ(writer.finish(), 0);
+  ASSERT_EQ(writer.required_size(), 3 + 300 * 9);
+}
+
+TEST(Writer, FinishAfterError) {
+  Writer writer(nullptr, 0);
+  writer.write("foo");
+  mpack_writer_flag_error(writer.mpack_writer(), mpack_error_memory);
+  ASSERT_THROW(writer.finish(), exceptions::PalimpsestError);
+
+  // The writer can be reused for a new message
+  writer.reset();
+  writer.write("foo");
+  ASSERT_EQ(writer.finish(), 0);
+  ASSERT_EQ(writer.required_size(), 4);
+}
+
+TEST_F(WriterTest, Reset) {
+  for (unsigned bytes = 0; bytes < MPACK_BUFFER_SIZE + 1; ++bytes) {
+    writer_->write(int8_t(42));
+  }
+  ASSERT_EQ(writer_->finish(), MPACK_BUFFER_SIZE + 1);
+  const size_t capacity = writer_->capacity();
+  ASSERT_GT(capacity, MPACK_BUFFER_SIZE);
+
+  writer_->reset();
+  writer_->write("foo");
+  ASSERT_EQ(writer_->finish(), 4);
+  ASSERT_EQ(writer_->capacity(), capacity);
+  ASSERT_EQ(writer_->data(), buffer_.data());
+  ASSERT_EQ(std::string(buffer_.data(), 4), "\xa3" "foo");
+}
+
+TEST(Writer, ResetUnfinishedMessage) {
+  Writer writer;
+  writer.start_map(2);
+  writer.write("foo");
+  writer.reset();
+  writer.write("bar");
+  ASSERT_EQ(writer.finish(), 4);
+  ASSERT_EQ(std::string(writer.data(), 4), "\xa3" "bar");
+}
+
+TEST(Writer, ResetFixedBuffer) {
+  char memory[8];
+  Writer writer(memory, sizeof(memory));
+  writer.write(std::string(10, 'a'));
+  ASSERT_EQ(writer.finish(), 0);
+  ASSERT_EQ(writer.required_size(), 11);
+
+  writer.reset();
+  writer.write("foo");
+  ASSERT_EQ(writer.finish(), 4);
+  ASSERT_EQ(writer.required_size(), 4);
+  ASSERT_EQ(std::string(memory, 4), "\xa3" "foo");
+}
+
+TEST(Writer, OwnedBuffer) {
+  std::vector<char> reference_buffer;
+  Writer reference(reference_buffer);
+  reference.write(std::string(2 * MPACK_BUFFER_SIZE, 'a'));
+  reference.write(Eigen::Vector3d{1.0, 2.0, 3.0});
+  const size_t reference_size = reference.finish();
+
+  Writer writer;
+  ASSERT_EQ(writer.capacity(), MPACK_BUFFER_SIZE);
+  for (int message = 0; message < 3; ++message) {
+    writer.reset();
+    writer.write(std::string(2 * MPACK_BUFFER_SIZE, 'a'));
+    writer.write(Eigen::Vector3d{1.0, 2.0, 3.0});
+    ASSERT_EQ(writer.finish(), reference_size);
+    ASSERT_EQ(std::string(writer.data(), reference_size),
+              std::string(reference_buffer.data(), reference_size));
+  }
+  ASSERT_GE(writer.capacity(), reference_size);
+}
+
 TEST_F(WriterTest, GrowBufferAsNeeded) {
   ASSERT_LE(buffer_.size(), MPACK_BUFFER_SIZE);
   for (unsigned bytes = 0; bytes < MPACK_BUFFER_SIZE + 1; ++bytes) {
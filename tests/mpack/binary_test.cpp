@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/mpack/binary.h"
+
+#include <gtest/gtest.h>
+#include <mpack.h>
+
+#include <Eigen/Core>
+#include <string>
+#include <vector>
+
+#include "palimpsest/mpack/Writer.h"
+#include "palimpsest/mpack/expect.h"
+#include "palimpsest/mpack/read.h"
+
+namespace palimpsest::mpack {
+
+class BinaryTest : public ::testing::Test {
+ protected:
+  void SetUp() override { writer_.set_array_encoding(ArrayEncoding::kBinary); }
+
+  //! Parse what has been written so far.
+  mpack_node_t parse() {
+    size_ = writer_.finish();
+    mpack_tree_init_data(&tree_, buffer_.data(), size_);
+    mpack_tree_parse(&tree_);
+    return mpack_tree_root(&tree_);
+  }
+
+  void TearDown() override { mpack_tree_destroy(&tree_); }
+
+ protected:
+  //! Internal byte buffer
+  std::vector<char> buffer_;
+
+  //! Writer
+  Writer writer_{buffer_};
+
+  //! Size of the message
+  size_t size_ = 0;
+
+  //! Tree
+  mpack_tree_t tree_;
+};
+
+TEST_F(BinaryTest, Layout) {
+  writer_.write(Eigen::Vector2d{1.0, -2.0});
+  mpack_node_t node = parse();
+  ASSERT_EQ(mpack_node_type(node), mpack_type_bin);
+  ASSERT_EQ(size_, 2 + kBinaryShapeSize + 2 * sizeof(double));
+  ASSERT_EQ(std::string(buffer_.data(), 2 + kBinaryShapeSize),
+            std::string("\xc4\x18\x02\x00\x00\x00\x01\x00\x00\x00", 10));
+
+  uint32_t rows = 0;
+  uint32_t cols = 0;
+  ASSERT_TRUE(read_binary_shape(mpack_node_bin_data(node),
+                                mpack_node_bin_size(node), rows, cols));
+  ASSERT_EQ(rows, 2);
+  ASSERT_EQ(cols, 1);
+}
+
+TEST_F(BinaryTest, ReadNodes) {
+  const Eigen::VectorXd vector = Eigen::VectorXd::LinSpaced(1000, 0.0, 1.0);
+  Eigen::Matrix3d matrix;
+  matrix << 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0;
+  writer_.start_array(4);
+  writer_.write(Eigen::Vector2d{1.0, 2.0});
+  writer_.write(Eigen::Vector3d{3.0, 4.0, 5.0});
+  writer_.write(vector);
+  writer_.write(matrix);
+  writer_.finish_array();
+  mpack_node_t root = parse();
+
+  Eigen::Vector2d vector2d;
+  Eigen::Vector3d vector3d;
+  Eigen::VectorXd vector_xd(1000);
+  Eigen::Matrix3d matrix3d;
+  read(mpack_node_array_at(root, 0), vector2d);
+  read(mpack_node_array_at(root, 1), vector3d);
+  read(mpack_node_array_at(root, 2), vector_xd);
+  read(mpack_node_array_at(root, 3), matrix3d);
+  ASSERT_EQ(mpack_tree_error(&tree_), mpack_ok);
+  ASSERT_EQ(vector2d, Eigen::Vector2d(1.0, 2.0));
+  ASSERT_EQ(vector3d, Eigen::Vector3d(3.0, 4.0, 5.0));
+  ASSERT_EQ(vector_xd, vector);
+  ASSERT_EQ(matrix3d, matrix);
+
+  Eigen::VectorXd wrong_size(999);
+  ASSERT_THROW(read(mpack_node_array_at(root, 2), wrong_size), TypeError);
+}
+
+TEST(Binary, ExpectStream) {
+  std::vector<char> buffer;
+  Writer writer(buffer);
+  writer.set_array_encoding(ArrayEncoding::kBinary);
+  writer.write(Eigen::Vector3d{3.0, 4.0, 5.0});
+  writer.write(Eigen::VectorXd::Ones(12).eval());
+  const size_t size = writer.finish();
+
+  mpack_reader_t reader;
+  mpack_reader_init_data(&reader, buffer.data(), size);
+  Eigen::Vector3d vector3d;
+  Eigen::VectorXd vector_xd(12);
+  expect(&reader, vector3d);
+  expect(&reader, vector_xd);
+  ASSERT_EQ(mpack_reader_destroy(&reader), mpack_ok);
+  ASSERT_EQ(vector3d, Eigen::Vector3d(3.0, 4.0, 5.0));
+  ASSERT_EQ(vector_xd, Eigen::VectorXd::Ones(12));
+
+  mpack_reader_init_data(&reader, buffer.data(), size);
+  Eigen::Vector2d vector2d;
+  expect(&reader, vector2d);
+  ASSERT_EQ(mpack_reader_destroy(&reader), mpack_error_type);
+}
+
+TEST(Binary, MalformedShape) {
+  const char blob[12] = {2, 0, 0, 0, 1, 0, 0, 0};
+  uint32_t rows = 0;
+  uint32_t cols = 0;
+  ASSERT_FALSE(read_binary_shape(blob, sizeof(blob), rows, cols));
+  ASSERT_FALSE(read_binary_shape(blob, 4, rows, cols));
+
+  Eigen::Vector2d vector = Eigen::Vector2d::Zero();
+  ASSERT_FALSE(decode_binary(blob, sizeof(blob), vector));
+  ASSERT_EQ(vector, Eigen::Vector2d::Zero());
+}
+
+}  // namespace palimpsest::mpack
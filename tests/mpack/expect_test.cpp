@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/mpack/expect.h"
+
+#include <gtest/gtest.h>
+#include <mpack.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "palimpsest/mpack/Writer.h"
+
+namespace palimpsest::mpack {
+
+class ExpectTest : public ::testing::Test {
+ protected:
+  //! Initialize the reader on what has been written so far.
+  void start_reading() {
+    size_t size = writer_.finish();
+    mpack_reader_init_data(&reader_, buffer_.data(), size);
+  }
+
+  void TearDown() override { mpack_reader_destroy(&reader_); }
+
+ protected:
+  //! Internal byte buffer
+  std::vector<char> buffer_;
+
+  //! Writer
+  Writer writer_{buffer_};
+
+  //! Reader
+  mpack_reader_t reader_;
+};
+
+TEST_F(ExpectTest, Scalars) {
+  writer_.write(true);
+  writer_.write(-12);
+  writer_.write(42u);
+  writer_.write(3.5);
+  writer_.write(std::string("foo"));
+  start_reading();
+
+  bool flag = false;
+  int32_t offset = 0;
+  uint64_t count = 0;
+  double number = 0.0;
+  std::string name;
+  expect(&reader_, flag);
+  expect(&reader_, offset);
+  expect(&reader_, count);
+  expect(&reader_, number);
+  expect(&reader_, name);
+  ASSERT_EQ(mpack_reader_error(&reader_), mpack_ok);
+  ASSERT_TRUE(flag);
+  ASSERT_EQ(offset, -12);
+  ASSERT_EQ(count, 42u);
+  ASSERT_DOUBLE_EQ(number, 3.5);
+  ASSERT_EQ(name, "foo");
+}
+
+TEST_F(ExpectTest, EigenTypes) {
+  const Eigen::Vector3d vector{1.0, 2.0, 3.0};
+  const Eigen::Quaterniond quat{0.0, 1.0, 0.0, 0.0};
+  Eigen::Matrix3d matrix;
+  matrix << 1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0;
+  writer_.write(vector);
+  writer_.write(quat);
+  writer_.write(matrix);
+  start_reading();
+
+  Eigen::Vector3d read_vector;
+  Eigen::Quaterniond read_quat;
+  Eigen::Matrix3d read_matrix;
+  expect(&reader_, read_vector);
+  expect(&reader_, read_quat);
+  expect(&reader_, read_matrix);
+  ASSERT_EQ(mpack_reader_error(&reader_), mpack_ok);
+  ASSERT_TRUE(read_vector.isApprox(vector));
+  ASSERT_TRUE(read_quat.isApprox(quat));
+  ASSERT_TRUE(read_matrix.isApprox(matrix));
+}
+
+TEST_F(ExpectTest, TypeMismatch) {
+  writer_.write(std::string("foo"));
+  start_reading();
+
+  double number = 0.0;
+  expect(&reader_, number);
+  ASSERT_EQ(mpack_reader_error(&reader_), mpack_error_type);
+}
+
+TEST_F(ExpectTest, LengthMismatch) {
+  writer_.write(Eigen::Vector3d{1.0, 2.0, 3.0});
+  start_reading();
+
+  Eigen::VectorXd vector = Eigen::VectorXd::Zero(4);
+  expect(&reader_, vector);
+  ASSERT_EQ(mpack_reader_error(&reader_), mpack_error_type);
+}
+
+TEST_F(ExpectTest, TruncateSkipsElements) {
+  writer_.write(std::vector<double>{1.0, 2.0, 3.0, 4.0, 5.0});
+  writer_.write(Eigen::Vector3d{1.0, 2.0, 3.0});
+  writer_.write(std::string("foobar"));
+  start_reading();
+
+  std::vector<double> list;
+  list.reserve(2);
+  Eigen::VectorXd vector = Eigen::VectorXd::Zero(2);
+  std::string name;
+  name.reserve(3);
+  const size_t capacity = name.capacity();
+  expect(&reader_, list, ResizePolicy::kTruncate);
+  expect(&reader_, vector, ResizePolicy::kTruncate);
+  expect(&reader_, name, ResizePolicy::kTruncate);
+  ASSERT_EQ(mpack_reader_error(&reader_), mpack_ok);
+  ASSERT_EQ(list.size(), std::min<size_t>(list.capacity(), 5));
+  for (size_t i = 0; i < list.size(); ++i) {
+    ASSERT_EQ(list[i], static_cast<double>(i + 1));
+  }
+  ASSERT_EQ(vector, Eigen::Vector2d(1.0, 2.0));
+  ASSERT_EQ(name, std::string("foobar").substr(0, capacity));
+}
+
+TEST_F(ExpectTest, ResizePolicyError) {
+  writer_.write(std::vector<double>{1.0, 2.0, 3.0});
+  start_reading();
+
+  std::vector<double> list;
+  expect(&reader_, list, ResizePolicy::kError);
+  ASSERT_EQ(mpack_reader_error(&reader_), mpack_error_type);
+}
+
+TEST_F(ExpectTest, UnknownType) {
+  start_reading();
+  std::vector<int> unknown;
+  ASSERT_THROW(expect(&reader_, unknown), TypeError);
+}
+
+}  // namespace palimpsest::mpack
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/mpack/read_doubles.h"
+
+#include <gtest/gtest.h>
+#include <mpack.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "palimpsest/mpack/Writer.h"
+
+namespace palimpsest::mpack {
+
+namespace {
+
+//! Serialize doubles one at a time with MPack.
+std::string write_doubles(const std::vector<double> &values) {
+  std::vector<char> buffer;
+  Writer writer(buffer);
+  for (double value : values) {
+    mpack_write_double(writer.mpack_writer(), value);
+  }
+  const size_t size = writer.finish();
+  return std::string(buffer.data(), size);
+}
+
+//! Serialize doubles one at a time as a MessagePack array.
+std::string write_array(const std::vector<double> &values) {
+  std::vector<char> buffer;
+  Writer writer(buffer);
+  mpack_start_array(writer.mpack_writer(), values.size());
+  for (double value : values) {
+    mpack_write_double(writer.mpack_writer(), value);
+  }
+  mpack_finish_array(writer.mpack_writer());
+  const size_t size = writer.finish();
+  return std::string(buffer.data(), size);
+}
+
+}  // namespace
+
+TEST(ReadDoubles, KernelName) {
+  const std::string kernel = expect_doubles_kernel();
+  ASSERT_TRUE(kernel == "avx2" || kernel == "ssse3" || kernel == "scalar");
+}
+
+TEST(ReadDoubles, ReadNode) {
+  const std::vector<double> expected = {1.5, -2.0, 3.25, 0.0};
+  const std::string message = write_array(expected);
+  mpack_tree_t tree;
+  mpack_tree_init_data(&tree, message.data(), message.size());
+  mpack_tree_parse(&tree);
+  mpack_node_t node = mpack_tree_root(&tree);
+
+  std::vector<double> values(expected.size());
+  ASSERT_TRUE(read_doubles(node, values.data(), values.size()));
+  ASSERT_EQ(values, expected);
+  ASSERT_FALSE(read_doubles(node, values.data(), values.size() + 1));
+  ASSERT_EQ(mpack_tree_destroy(&tree), mpack_ok);
+}
+
+TEST(ReadDoubles, ReadNodeMixedTypes) {
+  std::vector<char> buffer;
+  Writer writer(buffer);
+  mpack_start_array(writer.mpack_writer(), 2);
+  mpack_write_double(writer.mpack_writer(), 1.5);
+  mpack_write_int(writer.mpack_writer(), 2);
+  mpack_finish_array(writer.mpack_writer());
+  const size_t size = writer.finish();
+
+  mpack_tree_t tree;
+  mpack_tree_init_data(&tree, buffer.data(), size);
+  mpack_tree_parse(&tree);
+  double values[2];
+  ASSERT_FALSE(read_doubles(mpack_tree_root(&tree), values, 2));
+  ASSERT_EQ(mpack_tree_destroy(&tree), mpack_ok);
+}
+
+TEST(ReadDoubles, SameValuesAsMPack) {
+  for (size_t count : {0, 1, 2, 3, 4, 5, 7, 8, 9, 16, 17, 63, 64, 65, 1000}) {
+    std::vector<double> expected(count);
+    for (size_t i = 0; i < count; ++i) {
+      expected[i] = 0.37 * static_cast<double>(i) - 5.0;
+    }
+    std::string message = write_doubles(expected);
+    message.push_back('\xc3');  // true after the doubles
+
+    mpack_reader_t reader;
+    mpack_reader_init_data(&reader, message.data(), message.size());
+    std::vector<double> values(count);
+    ASSERT_TRUE(expect_doubles(&reader, values.data(), count)) << count;
+    ASSERT_EQ(values, expected) << count << " values";
+    ASSERT_TRUE(mpack_expect_bool(&reader));
+    ASSERT_EQ(mpack_reader_destroy(&reader), mpack_ok);
+  }
+}
+
+TEST(ReadDoubles, SpecialValues) {
+  const std::vector<double> expected = {
+      0.0,
+      -0.0,
+      std::numeric_limits<double>::infinity(),
+      -std::numeric_limits<double>::infinity(),
+      std::numeric_limits<double>::denorm_min(),
+      std::numeric_limits<double>::max(),
+  };
+  const std::string message = write_doubles(expected);
+  mpack_reader_t reader;
+  mpack_reader_init_data(&reader, message.data(), message.size());
+  std::vector<double> values(expected.size());
+  ASSERT_TRUE(expect_doubles(&reader, values.data(), values.size()));
+  ASSERT_EQ(values, expected);
+  ASSERT_TRUE(std::signbit(values[1]));
+  ASSERT_EQ(mpack_reader_destroy(&reader), mpack_ok);
+}
+
+TEST(ReadDoubles, OtherTypeLeavesReaderUnmoved) {
+  for (size_t position : {0, 1, 4, 8, 9}) {
+    std::vector<double> expected(10, 2.5);
+    std::string message = write_doubles(expected);
+    message[9 * position] = '\xca';  // float32 tag
+
+    mpack_reader_t reader;
+    mpack_reader_init_data(&reader, message.data(), message.size());
+    std::vector<double> values(expected.size());
+    ASSERT_FALSE(expect_doubles(&reader, values.data(), values.size()))
+        << position;
+    ASSERT_EQ(mpack_reader_remaining(&reader, nullptr), message.size());
+    mpack_reader_destroy(&reader);
+  }
+}
+
+TEST(ReadDoubles, NotEnoughBytes) {
+  const std::string message = write_doubles({1.0, 2.0, 3.0});
+  mpack_reader_t reader;
+  mpack_reader_init_data(&reader, message.data(), message.size() - 1);
+  double values[3];
+  ASSERT_FALSE(expect_doubles(&reader, values, 3));
+  ASSERT_EQ(mpack_reader_remaining(&reader, nullptr), message.size() - 1);
+  ASSERT_EQ(mpack_reader_destroy(&reader), mpack_ok);
+}
+
+}  // namespace palimpsest::mpack
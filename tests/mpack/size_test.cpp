@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/mpack/size.h"
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "palimpsest/mpack/Writer.h"
+
+namespace palimpsest::mpack {
+
+namespace {
+
+//! Number of bytes the writer produces for a value.
+template <typename T>
+size_t written_size(const T& value) {
+  std::vector<char> buffer;
+  Writer writer(buffer);
+  write<T>(writer.mpack_writer(), value);
+  return writer.finish();
+}
+
+}  // namespace
+
+TEST(Size, Integers) {
+  for (int64_t value :
+       {int64_t(0), int64_t(127), int64_t(128), int64_t(255), int64_t(256),
+        int64_t(65535), int64_t(65536), int64_t(4294967295), int64_t(1) << 32,
+        int64_t(-1), int64_t(-32), int64_t(-33), int64_t(-128), int64_t(-129),
+        int64_t(-32768), int64_t(-32769), int64_t(INT32_MIN),
+        int64_t(INT32_MIN) - 1}) {
+    ASSERT_EQ(serialized_size(value), written_size(value)) << value;
+  }
+  for (uint64_t value : {uint64_t(0), uint64_t(255), uint64_t(65536),
+                         std::numeric_limits<uint64_t>::max()}) {
+    ASSERT_EQ(serialized_size(value), written_size(value)) << value;
+  }
+  const int8_t small = -100;
+  ASSERT_EQ(serialized_size(small), written_size(small));
+}
+
+TEST(Size, Strings) {
+  for (size_t length : {0, 31, 32, 255, 256, 65535, 65536}) {
+    const std::string str(length, 'a');
+    ASSERT_EQ(serialized_size(str), written_size(str)) << length;
+  }
+  const std::vector<std::string> strings = {"a", std::string(40, 'b')};
+  ASSERT_EQ(serialized_size(strings), written_size(strings));
+}
+
+TEST(Size, FixedSizeTypes) {
+  ASSERT_EQ(serialized_size(true), written_size(true));
+  ASSERT_EQ(serialized_size(1.0f), written_size(1.0f));
+  ASSERT_EQ(serialized_size(1.0), written_size(1.0));
+  const Eigen::Vector2d vec2 = Eigen::Vector2d::Zero();
+  const Eigen::Vector3d vec3 = Eigen::Vector3d::Zero();
+  const Eigen::Quaterniond quat = Eigen::Quaterniond::Identity();
+  const Eigen::Matrix3d matrix = Eigen::Matrix3d::Identity();
+  ASSERT_EQ(serialized_size(vec2), written_size(vec2));
+  ASSERT_EQ(serialized_size(vec3), written_size(vec3));
+  ASSERT_EQ(serialized_size(quat), written_size(quat));
+  ASSERT_EQ(serialized_size(matrix), written_size(matrix));
+  ASSERT_EQ(fixed_serialized_size<int>, 0);
+  ASSERT_EQ(fixed_serialized_size<std::string>, 0);
+}
+
+TEST(Size, Containers) {
+  for (Eigen::Index length : {0, 15, 16}) {
+    const Eigen::VectorXd vec = Eigen::VectorXd::Zero(length);
+    ASSERT_EQ(serialized_size(vec), written_size(vec)) << length;
+  }
+  const std::vector<double> doubles(20, 1.0);
+  const std::vector<Eigen::Vector3d> vectors(3, Eigen::Vector3d::Zero());
+  const std::vector<Eigen::VectorXd> dynamic_vectors = {
+      Eigen::VectorXd::Zero(2), Eigen::VectorXd::Zero(17)};
+  ASSERT_EQ(serialized_size(doubles), written_size(doubles));
+  ASSERT_EQ(serialized_size(vectors), written_size(vectors));
+  ASSERT_EQ(serialized_size(dynamic_vectors), written_size(dynamic_vectors));
+}
+
+TEST(Size, UnknownType) {
+  const std::vector<int> unknown = {1, 2, 3};
+  ASSERT_THROW(serialized_size(unknown), exceptions::TypeError);
+}
+
+}  // namespace palimpsest::mpack
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2024 Inria
+
+#include "palimpsest/mpack/write_doubles.h"
+
+#include <gtest/gtest.h>
+#include <mpack.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "palimpsest/mpack/Writer.h"
+
+namespace palimpsest::mpack {
+
+namespace {
+
+//! Serialize doubles one at a time with MPack.
+std::string write_one_at_a_time(const std::vector<double> &values) {
+  std::vector<char> buffer;
+  Writer writer(buffer);
+  for (double value : values) {
+    mpack_write_double(writer.mpack_writer(), value);
+  }
+  const size_t size = writer.finish();
+  return std::string(buffer.data(), size);
+}
+
+//! Serialize doubles in bulk to a buffer of a given initial size.
+std::string write_in_bulk(const std::vector<double> &values,
+                          size_t initial_size) {
+  std::vector<char> buffer(initial_size);
+  Writer writer(buffer);
+  write_doubles(writer.mpack_writer(), values.data(), values.size());
+  const size_t size = writer.finish();
+  return std::string(buffer.data(), size);
+}
+
+}  // namespace
+
+TEST(WriteDoubles, KernelName) {
+  const std::string kernel = write_doubles_kernel();
+  ASSERT_TRUE(kernel == "avx2" || kernel == "ssse3" || kernel == "scalar");
+}
+
+TEST(WriteDoubles, SameBytesAsMPack) {
+  for (size_t count : {0, 1, 2, 3, 4, 5, 7, 8, 9, 16, 17, 63, 64, 65, 1000}) {
+    std::vector<double> values(count);
+    for (size_t i = 0; i < count; ++i) {
+      values[i] = 0.37 * static_cast<double>(i) - 5.0;
+    }
+    const std::string expected = write_one_at_a_time(values);
+    ASSERT_EQ(expected.size(), 9 * count);
+    for (size_t initial_size : {size_t(16), size_t(100), size_t(10000)}) {
+      ASSERT_EQ(write_in_bulk(values, initial_size), expected)
+          << count << " values, initial buffer size " << initial_size;
+    }
+  }
+}
+
+TEST(WriteDoubles, SpecialValues) {
+  const std::vector<double> values = {
+      0.0,
+      -0.0,
+      std::numeric_limits<double>::infinity(),
+      -std::numeric_limits<double>::infinity(),
+      std::numeric_limits<double>::quiet_NaN(),
+      std::numeric_limits<double>::denorm_min(),
+      std::numeric_limits<double>::max(),
+  };
+  ASSERT_EQ(write_in_bulk(values, 1024), write_one_at_a_time(values));
+}
+
+TEST(WriteDoubles, FixedBuffer) {
+  std::vector<double> values(100, 1.5);
+  const std::string expected = write_one_at_a_time(values);
+  std::vector<char> memory(expected.size() + 1, '\x42');
+  for (size_t capacity :
+       {size_t(0), size_t(10), size_t(500), expected.size()}) {
+    Writer writer(memory.data(), capacity);
+    write_doubles(writer.mpack_writer(), values.data(), values.size());
+    const size_t size = writer.finish();
+    ASSERT_EQ(writer.required_size(), expected.size());
+    ASSERT_EQ(memory[capacity], '\x42');
+    if (capacity == expected.size()) {
+      ASSERT_EQ(std::string(memory.data(), size), expected);
+    } else {
+      ASSERT_EQ(size, 0);
+    }
+  }
+}
+
+}  // namespace palimpsest::mpack